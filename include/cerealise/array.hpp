@@ -5,13 +5,14 @@
 namespace cerealise {
 
 template <typename T, size_t N> struct Adapter<std::array<T, N>> {
-  template <typename TT, typename F> static bool adapt(TT &v, F &f) {
-    for (auto &element : v)
-      if (!f(element))
-        return false;
-
-    return true;
+  template <typename TT, typename F>
+  static constexpr bool adapt(TT &v, F &f) {
+    return detail::adapt_range(v.data(), N, f);
   }
 };
 
+template <typename T, size_t N>
+struct FixedSizeTrait<std::array<T, N>>
+    : std::bool_constant<detail::FixedSize<T>> {};
+
 } // namespace cerealise
@@ -1,19 +1,105 @@
 #pragma once
 #include <algorithm>
 #include <bit>
+#include <concepts>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
 #include <type_traits>
 
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 namespace cerealise {
 
+/// format policy, which selects the byte order of fixed-width values
+///
+/// integers is used by fixedint (the default for integer types), and natives
+/// by native (the default for floating-point types)
+template <std::endian integers_p, std::endian natives_p> struct ByteOrder {
+  static constexpr std::endian integers = integers_p;
+  static constexpr std::endian natives = natives_p;
+};
+
+/// big-endian integers and little-endian floating-point values; the default
+using BigEndian = ByteOrder<std::endian::big, std::endian::little>;
+
+/// little-endian integers and floating-point values
+using LittleEndian = ByteOrder<std::endian::little, std::endian::little>;
+
+/// the byte order of the host, so that fixed-width values are copied without
+/// swapping; only use this between machines with the same byte order
+using HostEndian = ByteOrder<std::endian::native, std::endian::native>;
+
+template <typename F>
+concept FormatPolicy = requires {
+  { F::integers } -> std::convertible_to<std::endian>;
+  { F::natives } -> std::convertible_to<std::endian>;
+};
+
+namespace detail {
+/// converts a pointer to a memory resource of type R to void *, via a
+/// pointer to its std::pmr::memory_resource base; defined in pmr.hpp
+template <typename R> struct ResourceCast;
+} // namespace detail
+
+/// a pointer to a std::pmr::memory_resource, held without this header
+/// depending on <memory_resource>
+///
+/// it can be set from a pointer to any memory resource where
+/// cerealise/pmr.hpp is included, as it is by vector.hpp, string.hpp and
+/// delta.hpp
+class ResourcePtr {
+public:
+  ResourcePtr() = default;
+  ResourcePtr(std::nullptr_t) {}
+
+  template <typename R>
+  ResourcePtr(R *r) : p(detail::ResourceCast<R>::to_void(r)) {}
+
+  explicit operator bool() const { return p != nullptr; }
+
+  /// the std::pmr::memory_resource pointed to, as void *
+  void *get() const { return p; }
+
+  bool operator==(const ResourcePtr &) const = default;
+
+private:
+  void *p = nullptr;
+};
+
+/// options for parse, to limit resource use with untrusted input
+struct ParseOptions {
+  /// the maximum total size in bytes of the elements that containers may
+  /// allocate while parsing one value
+  size_t alloc_budget = std::numeric_limits<size_t>::max();
+
+  /// if not null, std::pmr containers are made to allocate from this resource
+  ResourcePtr resource = nullptr;
+};
+
 /// parse data from buf, writing into v
 ///
+/// Format is a FormatPolicy, which must match the one used to unparse the data
+///
 /// buf_len: length of buf, the maximum possible size
 /// bytes_read: the number of bytes read from buf
 ///
+/// containers check that their length could fit in the rest of buf before
+/// allocating, and parsing fails if options.alloc_budget would be exceeded
+///
 /// returns true if parsing was successful (enough data, and no other errors)
-template <typename T>
-bool parse(T &v, uint8_t *buf, size_t buf_len, size_t &bytes_read);
+template <FormatPolicy Format = BigEndian, typename T>
+bool parse(T &v, const uint8_t *buf, size_t buf_len, size_t &bytes_read,
+           const ParseOptions &options = {});
+
+/// parse data from buf, as above
+template <FormatPolicy Format = BigEndian, typename T>
+bool parse(T &v, std::span<const std::byte> buf, size_t &bytes_read,
+           const ParseOptions &options = {});
 
 /// serialise v into buf
 ///
@@ -22,43 +108,153 @@ bool parse(T &v, uint8_t *buf, size_t buf_len, size_t &bytes_read);
 ///
 /// returns true if serialisation was successful (enough space, and no other
 /// errors)
-template <typename T>
+template <FormatPolicy Format = BigEndian, typename T>
 bool unparse(const T &v, uint8_t *buf, size_t buf_len, size_t &bytes_written);
 
 /// get the number of bytes required to serialise v
 ///
+/// the size does not depend on the format, but it can be specified for
+/// consistency with parse and unparse
+///
 /// returns 0 in case of error
-template <typename T> size_t measure(const T &v);
+template <FormatPolicy Format = BigEndian, typename T>
+size_t measure(const T &v);
+
+/// a Sink provides memory for unparse to write into, one window at a time
+///
+/// next(buf, len, written, n) is called when the current window [buf,
+/// buf+len) is full, or does not have space for n more bytes; the first
+/// written bytes of it have been filled. It should update buf and len to
+/// point at a new window with space for at least n bytes if possible (and at
+/// least one byte in any case), and return false on error.
+///
+/// finish(buf, written) is called once unparsing is finished, with the
+/// current window and the number of bytes written to it.
+template <typename S>
+concept Sink = requires(S &s, uint8_t *&buf, size_t &len, size_t n) {
+  { s.next(buf, len, n, n) } -> std::convertible_to<bool>;
+  { s.finish(buf, n) } -> std::convertible_to<bool>;
+};
+
+/// a Sink which can refer to large blocks of bytes rather than copying them
+///
+/// reference(buf, len, written, p, n) is called instead of copying blocks
+/// passed to borrowed_bytes() which are at least reference_threshold() bytes
+/// long. The
+/// first written bytes of the current window have been filled, and should be
+/// followed by the n bytes at p, which remain valid until the sink is used.
+/// buf and len should be updated to point to a new window, as in next.
+template <typename S>
+concept ReferenceSink =
+    Sink<S> && requires(S &s, uint8_t *&buf, size_t &len, size_t n,
+                        const uint8_t *p) {
+      { s.reference(buf, len, n, p, n) } -> std::convertible_to<bool>;
+      { s.reference_threshold() } -> std::convertible_to<size_t>;
+    };
+
+/// a Source provides memory for parse to read from, one window at a time
+///
+/// next(buf, len, consumed, n) is called when the current window [buf,
+/// buf+len) has been read, or does not contain n more bytes; the first
+/// consumed bytes of it have been used. It should update buf and len to
+/// point at a new window starting at the first unused byte, with at least n
+/// bytes if possible, and return false on error. A window with less than n
+/// bytes (or no bytes) signals the end of the input.
+///
+/// finish(consumed) is called once parsing is finished, with the number of
+/// bytes of the current window that were used.
+template <typename S>
+concept Source =
+    requires(S &s, const uint8_t *&buf, size_t &len, size_t n) {
+      { s.next(buf, len, n, n) } -> std::convertible_to<bool>;
+      s.finish(n);
+    };
+
+/// parse data from source, writing into v
+///
+/// bytes_read: the total number of bytes read from source
+///
+/// the amount of data left in a source is not known, so only
+/// options.alloc_budget limits the size of containers
+///
+/// returns true if parsing was successful (enough data, and no other errors)
+template <FormatPolicy Format = BigEndian, typename T, Source S>
+bool parse(T &v, S &source, size_t &bytes_read,
+           const ParseOptions &options = {});
+
+/// serialise v into sink, which provides memory to write into as required
+///
+/// bytes_written: the total number of bytes written to sink
+///
+/// returns true if serialisation was successful (sink provided enough space,
+/// and no other errors)
+template <FormatPolicy Format = BigEndian, typename T, Sink S>
+bool unparse(const T &v, S &sink, size_t &bytes_written);
+
+/// check that buf contains a valid serialised T, without storing it
+///
+/// this accepts the same data as parse<Format>, except that booleans must be 0
+/// or 1, and does not allocate memory for the contents of containers
+///
+/// bytes_read: the number of bytes that parse would read from buf
+///
+/// returns true if the data is valid
+template <typename T, FormatPolicy Format = BigEndian>
+bool validate(const uint8_t *buf, size_t buf_len, size_t &bytes_read);
+
+/// find the end of a serialised T in buf, without parsing it
+///
+/// values with a fixed size, and containers of them, are skipped without
+/// looking at their contents, so this does not check that the data is valid
+///
+/// bytes_skipped: the number of bytes that parse would read from buf
+///
+/// returns true if buf is long enough to contain a T
+template <typename T, FormatPolicy Format = BigEndian>
+bool skip(const uint8_t *buf, size_t buf_len, size_t &bytes_skipped);
 
 template <typename T, class Enable = void> struct Adapter {
-  template <typename TT, typename F> static bool adapt(TT &v, F &f) {
+  template <typename TT, typename F>
+  static constexpr bool adapt(TT &v, F &f) {
     return T::template cerealise<TT, F>(v, f);
   }
 };
 
 template <typename T>
 struct Adapter<T, std::enable_if_t<std::is_integral_v<T>>> {
-  template <typename TT, typename F> static bool adapt(TT &v, F &f) {
+  template <typename TT, typename F>
+  static constexpr bool adapt(TT &v, F &f) {
     return f.fixedint(v);
   }
 };
 
 template <typename T>
 struct Adapter<T, std::enable_if_t<std::is_floating_point_v<T>>> {
-  template <typename TT, typename F> static bool adapt(TT &v, F &f) {
+  template <typename TT, typename F>
+  static constexpr bool adapt(TT &v, F &f) {
     return f.native(v);
   }
 };
 
 template <> struct Adapter<bool> {
-  template <typename TT, typename F> static bool adapt(TT &v, F &f) {
+  template <typename TT, typename F>
+  static constexpr bool adapt(TT &v, F &f) {
     return f.boolean(v);
   }
 };
 
-namespace detail {
+/// specialise this as std::true_type to declare that every value of T
+/// serialises to the same number of bytes; see has_fixed_size_v
+///
+/// this is true for builtin types, and std::array of fixed-size types.
+template <typename T, class Enable = void>
+struct FixedSizeTrait : std::false_type {};
 
-constexpr bool do_byte_swap = std::endian::native != std::endian::little;
+template <typename T>
+struct FixedSizeTrait<T, std::enable_if_t<std::is_arithmetic_v<T>>>
+    : std::true_type {};
+
+namespace detail {
 
 template <typename Signed, typename Unsigned = std::make_unsigned_t<Signed>>
 Unsigned encode_zigzag(Signed x) {
@@ -71,14 +267,282 @@ Signed decode_zigzag(Unsigned x) {
   return (x & 1) ? ~y : y;
 }
 
+template <typename Unsigned> constexpr Unsigned byteswap(Unsigned x) {
+#if defined(__GNUC__) || defined(__clang__)
+  if constexpr (sizeof(Unsigned) == 2)
+    return __builtin_bswap16(x);
+  else if constexpr (sizeof(Unsigned) == 4)
+    return __builtin_bswap32(x);
+  else if constexpr (sizeof(Unsigned) == 8)
+    return __builtin_bswap64(x);
+#endif
+  Unsigned y = 0;
+  for (size_t i = 0; i < sizeof(Unsigned); i++) {
+    y = (y << 8) | (x & 0xff);
+    x >>= 8;
+  }
+  return y;
+}
+
+/// read an unsigned integer of size bytes from p in the given byte order
+template <std::endian order, size_t size, typename Unsigned>
+Unsigned load_int(const uint8_t *p) {
+  Unsigned u = 0;
+  if constexpr (size == sizeof(Unsigned)) {
+    std::memcpy(&u, p, size);
+    if constexpr (order != std::endian::native && size > 1)
+      u = byteswap(u);
+  } else if constexpr (order == std::endian::big) {
+    for (size_t i = 0; i < size; i++)
+      u = (u << 8) | p[i];
+  } else {
+    for (size_t i = 0; i < size; i++)
+      u |= (Unsigned)p[i] << (i * 8);
+  }
+  return u;
+}
+
+/// write the low size bytes of u to p in the given byte order
+template <std::endian order, size_t size, typename Unsigned>
+void store_int(uint8_t *p, Unsigned u) {
+  if constexpr (size == sizeof(Unsigned)) {
+    if constexpr (order != std::endian::native && size > 1)
+      u = byteswap(u);
+    std::memcpy(p, &u, size);
+  } else {
+    for (size_t i = 0; i < size; i++) {
+      size_t byte = order == std::endian::big ? (size - 1) - i : i;
+      p[i] = (uint8_t)((u >> (byte * 8)) & 0xff);
+    }
+  }
+}
+
+/// the number of bytes needed to encode u as a varint
+template <typename Unsigned> constexpr size_t varint_length(Unsigned u) {
+  return ((size_t)std::bit_width((Unsigned)(u | 1)) + 6) / 7;
+}
+
+/// read 8 bytes from p as a little-endian integer
+inline uint64_t load_le64(const uint8_t *p) {
+  uint64_t x;
+  std::memcpy(&x, p, sizeof(x));
+  if constexpr (std::endian::native == std::endian::big)
+    x = byteswap(x);
+  return x;
+}
+
+/// reverse the bytes of each of n size-byte elements from src, writing to dst
+///
+/// dst and src may be equal, but must not otherwise overlap
+template <size_t size>
+void byteswap_block(uint8_t *dst, const uint8_t *src, size_t n) {
+  size_t i = 0;
+
+#if defined(__SSSE3__) || defined(__AVX2__)
+  if constexpr (size == 2 || size == 4 || size == 8) {
+    // pshufb mask which reverses each element within each 16-byte lane
+    alignas(32) static constexpr auto mask = [] {
+      struct {
+        int8_t bytes[32];
+      } m{};
+      for (size_t j = 0; j < 32; j++)
+        m.bytes[j] = (int8_t)((j / size) * size + (size - 1 - j % size));
+      return m;
+    }();
+
+#if defined(__AVX2__)
+    const __m256i mask_256 = _mm256_load_si256((const __m256i *)&mask);
+    for (; i + 32 / size <= n; i += 32 / size) {
+      __m256i x = _mm256_loadu_si256((const __m256i *)(src + i * size));
+      x = _mm256_shuffle_epi8(x, mask_256);
+      _mm256_storeu_si256((__m256i *)(dst + i * size), x);
+    }
+#endif
+    const __m128i mask_128 = _mm_load_si128((const __m128i *)&mask);
+    for (; i + 16 / size <= n; i += 16 / size) {
+      __m128i x = _mm_loadu_si128((const __m128i *)(src + i * size));
+      x = _mm_shuffle_epi8(x, mask_128);
+      _mm_storeu_si128((__m128i *)(dst + i * size), x);
+    }
+  }
+#endif
+
+  if constexpr (size == 2 || size == 4 || size == 8) {
+    using U = std::conditional_t<
+        size == 2, uint16_t, std::conditional_t<size == 4, uint32_t, uint64_t>>;
+    for (; i < n; i++) {
+      U u;
+      std::memcpy(&u, src + i * size, size);
+      u = byteswap(u);
+      std::memcpy(dst + i * size, &u, size);
+    }
+  } else {
+    for (; i < n; i++) {
+      uint8_t element[size];
+      std::copy_n(src + i * size, size, element);
+      std::reverse(element, element + size);
+      std::copy_n(element, size, dst + i * size);
+    }
+  }
+}
+
+/// buffer used to find the size of types declared with FixedSizeTrait, at
+/// compile time
+///
+/// this pretends to parse, filling everything with zeros or ones depending on
+/// fill, and fails on varints, which are always variable-length. It is run
+/// once with each fill and the sizes compared, to catch some (but not all)
+/// types which are declared fixed-size by mistake.
+template <bool fill> class FixedSizeBuf {
+public:
+  static constexpr bool parsing = true;
+
+  constexpr bool byte(uint8_t &x) {
+    x = fill ? 0xff : 0;
+    pos++;
+    return true;
+  }
+
+  constexpr bool boolean(bool &x) {
+    x = fill;
+    pos++;
+    return true;
+  }
+
+  constexpr bool bytes(uint8_t *p, size_t n) {
+    std::fill_n(p, n, fill ? 0xff : 0);
+    pos += n;
+    return true;
+  }
+
+  constexpr bool view(const uint8_t *&p, size_t n) {
+    p = nullptr;
+    pos += n;
+    return true;
+  }
+
+  template <size_t size_p = 0, typename T> constexpr bool fixedint(T &x) {
+    constexpr size_t size = size_p == 0 ? sizeof(T) : size_p;
+    static_assert(size <= sizeof(T), "data size must be less than type size");
+
+    x = fill ? (T)~(T)0 : (T)0;
+    pos += size;
+    return true;
+  }
+
+  template <typename T> constexpr bool native(T &x) {
+    x = T{};
+    pos += sizeof(T);
+    return true;
+  }
+
+  template <typename T> constexpr bool fixedints(T *x, size_t n) {
+    for (size_t i = 0; i < n; i++)
+      fixedint(x[i]);
+    return true;
+  }
+
+  template <typename T> constexpr bool natives(T *x, size_t n) {
+    for (size_t i = 0; i < n; i++)
+      native(x[i]);
+    return true;
+  }
+
+  template <typename T> constexpr bool varint(T &) { return false; }
+
+  template <typename T> constexpr bool varints(T *, size_t) { return false; }
+
+  template <typename T> constexpr bool operator()(T &x) {
+    return Adapter<std::remove_cv_t<T>>::template adapt<T, FixedSizeBuf>(x,
+                                                                         *this);
+  }
+
+  constexpr size_t bytes_read() const { return pos; }
+
+private:
+  size_t pos = 0;
+};
+
+struct FixedSizeInfo {
+  bool fixed;
+  size_t size;
+};
+
+template <typename T> constexpr FixedSizeInfo fixed_size_info() {
+  T v_zeros{};
+  FixedSizeBuf<false> zeros;
+  if (!zeros(v_zeros))
+    return {false, 0};
+
+  T v_ones{};
+  FixedSizeBuf<true> ones;
+  if (!ones(v_ones))
+    return {false, 0};
+
+  if (zeros.bytes_read() != ones.bytes_read())
+    return {false, 0};
+
+  return {true, zeros.bytes_read()};
+}
+
+template <typename T>
+concept FixedSizeConstant = requires {
+  typename std::bool_constant<fixed_size_info<T>().fixed>;
+};
+
+/// is T declared with FixedSizeTrait? Declaring a type whose size can not be
+/// found is an error, rather than quietly checking every field
+template <typename T> constexpr bool declared_fixed_size() {
+  if constexpr (!FixedSizeTrait<T>::value)
+    return false;
+  else if constexpr (!FixedSizeConstant<T>) {
+    static_assert(FixedSizeConstant<T>,
+                  "types declared with FixedSizeTrait must have a constexpr "
+                  "adapter, and be default-constructible at compile time");
+    return false;
+  } else {
+    static_assert(fixed_size_info<T>().fixed,
+                  "types declared with FixedSizeTrait must always serialise "
+                  "to the same number of bytes");
+    return true;
+  }
+}
+
+template <typename T>
+concept FixedSize = declared_fixed_size<std::remove_cv_t<T>>();
+
+/// buffer which reads from memory
+///
+/// if checked is false, the bounds are not checked; this is used for values
+/// with a fixed size, after checking the bounds for the whole value
+///
+/// if SourceT is not void, more data is requested from a Source when the
+/// current window has been read
+///
+/// Format is the FormatPolicy used for fixed-width values
+template <bool checked = true, typename SourceT = void,
+          typename Format = BigEndian>
 class ParseBuf {
 public:
+  using format = Format;
   static constexpr bool parsing = true;
+  static constexpr bool has_source = !std::is_void_v<SourceT>;
+  static constexpr bool swap_integers = Format::integers != std::endian::native;
+  static constexpr bool swap_natives = Format::natives != std::endian::native;
+
+  ParseBuf(const uint8_t *buf, size_t len, const ParseOptions &options = {})
+    requires(!has_source)
+      : buf(buf), len(len), budget(options.alloc_budget),
+        resource(options.resource) {}
 
-  ParseBuf(uint8_t *buf, size_t len) : buf(buf), len(len) {}
+  template <typename S = SourceT>
+    requires(has_source)
+  ParseBuf(S &source, const ParseOptions &options = {})
+      : source(&source), budget(options.alloc_budget),
+        resource(options.resource) {}
 
   bool byte(uint8_t &x) {
-    if (pos >= len)
+    if (checked && !reserve(1))
       return false;
     x = buf[pos++];
     return true;
@@ -93,13 +557,50 @@ public:
   }
 
   bool bytes(uint8_t *p, size_t n) {
-    for (size_t i = 0; i < n; i++) {
-      if (!byte(p[i]))
-        return false;
-    }
+    if constexpr (has_source) {
+      // read each window in turn rather than requiring n contiguous bytes, so
+      // that large blocks can be read from sources with small windows
+      while (n > len - pos) {
+        size_t chunk = len - pos;
+        std::copy_n(buf + pos, chunk, p);
+        pos += chunk;
+        p += chunk;
+        n -= chunk;
+
+        if (!next_window(n))
+          return false;
+      }
+    } else if (checked && n > len - pos)
+      return false;
+
+    std::copy_n(buf + pos, n, p);
+    pos += n;
     return true;
   }
 
+  /// point p at the next n bytes of the input, rather than copying them
+  ///
+  /// this is only possible when parsing from memory, not from a Source
+  bool view(const uint8_t *&p, size_t n)
+    requires(!has_source)
+  {
+    if (checked && n > len - pos)
+      return false;
+    p = buf + pos;
+    pos += n;
+    return true;
+  }
+
+  /// point p at the rest of the input, n bytes long, without moving past it
+  ///
+  /// this is only possible when parsing from memory, not from a Source
+  void peek(const uint8_t *&p, size_t &n) const
+    requires(!has_source)
+  {
+    p = buf + pos;
+    n = len - pos;
+  }
+
   template <size_t size_p = 0, typename T> bool fixedint(T &x) {
     // allow overriding size with only one parameter
     constexpr size_t size = size_p == 0 ? sizeof(T) : size_p;
@@ -109,11 +610,7 @@ public:
     if (!bytes(buf, size))
       return false;
 
-    x = (T)0;
-    for (size_t i = 0; i < size; i++) {
-      size_t byte = (size - 1) - i;
-      x |= (T)(buf[i]) << (byte * 8);
-    }
+    x = (T)load_int<Format::integers, size, std::make_unsigned_t<T>>(buf);
 
     // sign extend if necessary
     if constexpr (std::is_signed_v<T> && size < sizeof(T)) {
@@ -124,25 +621,72 @@ public:
   }
 
   template <typename T> bool native(T &x) {
-    if constexpr (do_byte_swap) {
-      uint8_t buf[sizeof(T)];
-      if (!bytes(buf, sizeof(T)))
-        return false;
+    uint8_t buf[sizeof(T)];
+    if (!bytes(buf, sizeof(T)))
+      return false;
 
-      for (size_t i = 0; i < sizeof(T) / 2; i++) {
-        size_t j = sizeof(T) - i;
-        std::swap(buf[i], buf[j]);
-      }
+    if constexpr (swap_natives)
+      std::reverse(buf, buf + sizeof(T));
 
-      x = *(T *)&buf;
-      return true;
-    } else
-      return bytes((uint8_t *)&x, sizeof(T));
+    std::memcpy(&x, buf, sizeof(T));
+    return true;
+  }
+
+  /// parse n integers, as with fixedint
+  template <typename T> bool fixedints(T *x, size_t n) {
+    if (!bytes((uint8_t *)x, n * sizeof(T)))
+      return false;
+
+    if constexpr (swap_integers && sizeof(T) > 1)
+      byteswap_block<sizeof(T)>((uint8_t *)x, (uint8_t *)x, n);
+    return true;
+  }
+
+  /// parse n values, as with native
+  template <typename T> bool natives(T *x, size_t n) {
+    if (!bytes((uint8_t *)x, n * sizeof(T)))
+      return false;
+
+    if constexpr (swap_natives && sizeof(T) > 1)
+      byteswap_block<sizeof(T)>((uint8_t *)x, (uint8_t *)x, n);
+    return true;
   }
 
   template <typename T> bool varint(T &x) {
     using uint = std::make_unsigned_t<T>;
 
+    if (len - pos >= 8) {
+      // fast path: find the end in the next 8 bytes, and gather the 7-bit
+      // groups without branching
+      uint64_t word = load_le64(buf + pos);
+      uint64_t ends = ~word & 0x8080808080808080;
+      if (ends) {
+        size_t n = std::countr_zero(ends) / 8 + 1;
+
+        // keep the first n bytes, most significant group at the top
+        if (n < 8)
+          word &= ((uint64_t)1 << (n * 8)) - 1;
+        word = byteswap(word) >> ((8 - n) * 8);
+
+        // compact the 7-bit groups into 14, 28 then 56-bit groups
+        word &= 0x7f7f7f7f7f7f7f7f;
+        word = ((word & 0x7f007f007f007f00) >> 1) | (word & 0x007f007f007f007f);
+        word = ((word & 0x3fff00003fff0000) >> 2) | (word & 0x00003fff00003fff);
+        word = ((word & 0x0fffffff00000000) >> 4) | (word & 0x000000000fffffff);
+
+        if constexpr (sizeof(T) < 8)
+          if (word >> (sizeof(T) * 8))
+            return false; // ran out of space
+
+        pos += n;
+        if constexpr (std::is_signed_v<T>)
+          x = decode_zigzag((uint)word);
+        else
+          x = (uint)word;
+        return true;
+      }
+    }
+
     uint u = 0;
     uint8_t b;
     do {
@@ -164,26 +708,195 @@ public:
     return true;
   }
 
+  /// parse n varints, as with varint
+  template <typename T> bool varints(T *x, size_t n) {
+    size_t i = 0;
+    while (i < n) {
+#if defined(__SSE2__)
+      if constexpr (!has_source && sizeof(T) >= 2) {
+        if (size_t decoded = varint_block(x + i, n - i)) {
+          i += decoded;
+          continue;
+        }
+      }
+#endif
+      // decode a few values one at a time before trying the fast path again
+      for (size_t end = std::min(n, i + 8); i < end; i++)
+        if (!varint(x[i]))
+          return false;
+    }
+    return true;
+  }
+
   template <typename T> bool operator()(T &x) {
-    return Adapter<std::remove_cv_t<T>>::template adapt<T, ParseBuf>(x, *this);
+    using U = std::remove_cv_t<T>;
+    // only types declared with FixedSizeTrait are parsed without checking
+    // each field, as the size of any other type may depend on its values
+    if constexpr (checked && FixedSize<U>) {
+      constexpr size_t size = fixed_size_info<U>().size;
+      if (reserve(size)) {
+        using Unchecked = ParseBuf<false, void, Format>;
+        Unchecked unchecked(buf + pos, size);
+        if (!Adapter<U>::template adapt<T, Unchecked>(x, unchecked))
+          return false;
+
+        pos += size;
+        return true;
+      } else if constexpr (!has_source)
+        return false;
+      // otherwise the source could not provide a big enough window, so fall
+      // back to checking each field
+    }
+    return Adapter<U>::template adapt<T, ParseBuf>(x, *this);
   }
 
-  size_t bytes_read() const { return pos; }
+  /// check that a container can hold n values of T, which take up at least
+  /// min_input bytes, before it allocates space for them
+  ///
+  /// this fails if there is not enough input left (when parsing from memory),
+  /// or if the allocation budget would be exceeded
+  template <typename T> bool check_length(size_t n, size_t min_input) {
+    if constexpr (!has_source)
+      if (min_input > len - pos)
+        return false;
+
+    if (n > budget / sizeof(T))
+      return false;
+    budget -= n * sizeof(T);
+    return true;
+  }
+
+  /// the resource that pmr containers should allocate from, or nullptr
+  ResourcePtr memory_resource() const { return resource; }
+
+  /// options for parsing part of the rest of the input separately, with the
+  /// remaining allocation budget
+  ParseOptions options() const { return {budget, resource}; }
+
+  size_t bytes_read() const { return done + pos; }
+
+  /// tell the source how much of the current window was used once finished
+  void finish()
+    requires(has_source)
+  {
+    source->finish(pos);
+  }
 
 private:
-  uint8_t *buf;
-  size_t len;
+#if defined(__SSE2__)
+  /// try to decode up to n varints from the next 16 bytes of input, if they
+  /// are all 1 or 2 bytes long
+  ///
+  /// returns the number of values decoded, or 0 if the input does not match
+  /// one of the patterns handled here
+  template <typename T> size_t varint_block(T *x, size_t n) {
+    if (n < 8 || len - pos < 16)
+      return 0;
+
+    __m128i chunk = _mm_loadu_si128((const __m128i *)(buf + pos));
+    // one bit per byte, set if another byte follows
+    unsigned mask = (unsigned)_mm_movemask_epi8(chunk);
+
+    uint16_t values[16];
+    size_t decoded;
+    if (mask == 0 && n >= 16) {
+      // 16 one-byte values
+      __m128i zero = _mm_setzero_si128();
+      _mm_storeu_si128((__m128i *)values, _mm_unpacklo_epi8(chunk, zero));
+      _mm_storeu_si128((__m128i *)(values + 8), _mm_unpackhi_epi8(chunk, zero));
+      decoded = 16;
+      pos += 16;
+    } else if ((mask & 0xff) == 0) {
+      // 8 one-byte values
+      __m128i zero = _mm_setzero_si128();
+      _mm_storeu_si128((__m128i *)values, _mm_unpacklo_epi8(chunk, zero));
+      decoded = 8;
+      pos += 8;
+    } else if (mask == 0x5555) {
+      // 8 two-byte values; in each 16-bit lane the first (high) byte is in
+      // the low half
+      __m128i high = _mm_and_si128(chunk, _mm_set1_epi16(0x7f));
+      __m128i low = _mm_srli_epi16(chunk, 8);
+      __m128i v = _mm_or_si128(_mm_slli_epi16(high, 7), low);
+      _mm_storeu_si128((__m128i *)values, v);
+      decoded = 8;
+      pos += 16;
+    } else
+      return 0;
+
+    for (size_t i = 0; i < decoded; i++) {
+      if constexpr (std::is_signed_v<T>)
+        x[i] = decode_zigzag((std::make_unsigned_t<T>)values[i]);
+      else
+        x[i] = values[i];
+    }
+    return decoded;
+  }
+#endif
+
+  /// get a new window from the source with (ideally) n bytes
+  bool next_window(size_t n)
+    requires(has_source)
+  {
+    if (!source->next(buf, len, pos, n))
+      return false;
+    done += pos;
+    pos = 0;
+    return len > 0;
+  }
+
+  /// make sure that n bytes are available in the current window
+  bool reserve(size_t n) {
+    if (n <= len - pos)
+      return true;
+
+    if constexpr (has_source)
+      return next_window(n) && n <= len;
+    else
+      return false;
+  }
+
+  const uint8_t *buf = nullptr;
+  size_t len = 0;
   size_t pos = 0;
+  size_t done = 0;
+
+  struct Empty {};
+  [[no_unique_address]] std::conditional_t<has_source, SourceT *, Empty> source;
+
+  size_t budget;
+  ResourcePtr resource = nullptr;
 };
 
+/// buffer which writes to memory
+///
+/// if checked is false, the bounds are not checked; this is used for values
+/// with a fixed size, after checking the bounds for the whole value
+///
+/// if SinkT is not void, more memory is requested from a Sink when the
+/// current window is full
+///
+/// Format is the FormatPolicy used for fixed-width values
+template <bool checked = true, typename SinkT = void,
+          typename Format = BigEndian>
 class UnparseBuf {
 public:
+  using format = Format;
   static constexpr bool parsing = false;
+  static constexpr bool has_sink = !std::is_void_v<SinkT>;
+  static constexpr bool swap_integers = Format::integers != std::endian::native;
+  static constexpr bool swap_natives = Format::natives != std::endian::native;
+
+  UnparseBuf(uint8_t *buf, size_t len)
+    requires(!has_sink)
+      : buf(buf), len(len) {}
 
-  UnparseBuf(uint8_t *buf, size_t len) : buf(buf), len(len) {}
+  template <typename S = SinkT>
+    requires(has_sink)
+  UnparseBuf(S &sink) : sink(&sink) {}
 
   bool byte(const uint8_t &x) {
-    if (pos >= len)
+    if (checked && !reserve(1))
       return false;
     buf[pos++] = x;
     return true;
@@ -192,10 +905,55 @@ public:
   bool boolean(const bool &x) { return byte(x ? 1 : 0); }
 
   bool bytes(const uint8_t *p, size_t n) {
-    for (size_t i = 0; i < n; i++) {
-      if (!byte(p[i]))
-        return false;
+    if constexpr (has_sink) {
+      // fill up each window rather than requiring n contiguous bytes, so that
+      // large blocks can be written to sinks with small windows
+      while (n > len - pos) {
+        size_t chunk = len - pos;
+        std::copy_n(p, chunk, buf + pos);
+        pos += chunk;
+        p += chunk;
+        n -= chunk;
+
+        if (!next_window(n))
+          return false;
+      }
+    } else if (checked && n > len - pos)
+      return false;
+
+    std::copy_n(p, n, buf + pos);
+    pos += n;
+    return true;
+  }
+
+  /// as bytes, but p must stay valid until the output has been used, so a
+  /// ReferenceSink can refer to it rather than copying it
+  bool borrowed_bytes(const uint8_t *p, size_t n) {
+    if constexpr (ReferenceSink<SinkT>) {
+      if (n >= sink->reference_threshold()) {
+        if (!sink->reference(buf, len, pos, p, n))
+          return false;
+        done += pos + n;
+        pos = 0;
+        return true;
+      }
     }
+
+    return bytes(p, n);
+  }
+
+  /// point p at space for the next n bytes of output, to be filled in by the
+  /// caller, and move past it
+  ///
+  /// returns false if there is not enough space, or the sink can not provide
+  /// n contiguous bytes
+  bool window(uint8_t *&p, size_t n)
+    requires(checked)
+  {
+    if (!reserve(n))
+      return false;
+    p = buf + pos;
+    pos += n;
     return true;
   }
 
@@ -207,30 +965,35 @@ public:
     // TODO: check that x is within range
 
     uint8_t buf[size];
-    for (size_t i = 0; i < size; i++) {
-      size_t byte = (size - 1) - i;
-      buf[i] = (uint8_t)((x >> (byte * 8)) & 0xff);
-    }
+    store_int<Format::integers, size>(buf, (std::make_unsigned_t<T>)x);
 
     return bytes(buf, size);
   }
 
   template <typename T> bool native(const T &x) {
-    uint8_t *x_ptr = (uint8_t *)&x;
+    uint8_t buf[sizeof(T)];
+    std::memcpy(buf, &x, sizeof(T));
 
-    if constexpr (do_byte_swap) {
-      uint8_t buf[sizeof(T)];
+    if constexpr (swap_natives)
+      std::reverse(buf, buf + sizeof(T));
 
-      std::copy(x_ptr, x_ptr + sizeof(T), buf);
+    return bytes(buf, sizeof(T));
+  }
 
-      for (size_t i = 0; i < sizeof(T) / 2; i++) {
-        size_t j = sizeof(T) - i;
-        std::swap(buf[i], buf[j]);
-      }
+  /// unparse n integers, as with fixedint
+  template <typename T> bool fixedints(const T *x, size_t n) {
+    if constexpr (swap_integers && sizeof(T) > 1)
+      return swapped_block(x, n);
+    else
+      return bytes((const uint8_t *)x, n * sizeof(T));
+  }
 
-      return bytes(buf, sizeof(T));
-    } else
-      return bytes(x_ptr, sizeof(T));
+  /// unparse n values, as with native
+  template <typename T> bool natives(const T *x, size_t n) {
+    if constexpr (swap_natives && sizeof(T) > 1)
+      return swapped_block(x, n);
+    else
+      return bytes((const uint8_t *)x, n * sizeof(T));
   }
 
   template <typename T> bool varint(const T &x) {
@@ -242,14 +1005,35 @@ public:
     else
       u = x;
 
-    // find required number of bytes
-    U remainder = u;
-    size_t bytes = 0;
-    do {
-      remainder >>= 7;
-      bytes += 1;
-    } while (remainder > 0);
+    size_t bytes = varint_length(u);
+
+    if (!checked || reserve(bytes)) {
+      if (bytes <= 8) {
+        // spread the 7-bit groups out into bytes without branching, the
+        // reverse of ParseBuf::varint
+        uint64_t word = (uint64_t)u;
+        word = ((word & 0x00fffffff0000000) << 4) | (word & 0x000000000fffffff);
+        word = ((word & 0x0fffc0000fffc000) << 2) | (word & 0x00003fff00003fff);
+        word = ((word & 0x3f803f803f803f80) << 1) | (word & 0x007f007f007f007f);
+        word |= 0x8080808080808080 & ~(uint64_t)0xff;
+        word = byteswap(word) >> ((8 - bytes) * 8);
+
+        if constexpr (std::endian::native == std::endian::big)
+          word = byteswap(word);
+        std::memcpy(buf + pos, &word, bytes);
+      } else {
+        for (size_t i = 0; i < bytes; i++) {
+          size_t byteno = bytes - 1 - i;
+          uint8_t b = (u >> (byteno * 7)) & 0x7f;
+          buf[pos + i] = byteno > 0 ? b | 0x80 : b;
+        }
+      }
+      pos += bytes;
+      return true;
+    } else if constexpr (!has_sink)
+      return false;
 
+    // the sink could not provide a big enough window
     for (int byteno = (int)bytes - 1; byteno >= 0; byteno--) {
       uint8_t b = (u >> (byteno * 7)) & 0x7f;
       if (byteno > 0)
@@ -260,17 +1044,105 @@ public:
     return true;
   }
 
+  /// unparse n varints, as with varint
+  template <typename T> bool varints(const T *x, size_t n) {
+    for (size_t i = 0; i < n; i++)
+      if (!varint(x[i]))
+        return false;
+    return true;
+  }
+
   template <typename T> bool operator()(const T &x) {
-    return Adapter<std::remove_cv_t<T>>::template adapt<const T, UnparseBuf>(
-        x, *this);
+    using U = std::remove_cv_t<T>;
+    if constexpr (checked && FixedSize<U>) {
+      constexpr size_t size = fixed_size_info<U>().size;
+      if (reserve(size)) {
+        using Unchecked = UnparseBuf<false, void, Format>;
+        Unchecked unchecked(buf + pos, size);
+        if (!Adapter<U>::template adapt<const T, Unchecked>(x, unchecked))
+          return false;
+
+        pos += size;
+        return true;
+      } else if constexpr (!has_sink)
+        return false;
+      // otherwise the sink could not provide a big enough window, so fall back
+      // to checking each field
+    }
+    return Adapter<U>::template adapt<const T, UnparseBuf>(x, *this);
   }
 
-  size_t bytes_written() const { return pos; }
+  size_t bytes_written() const { return done + pos; }
+
+  /// pass the current window to the sink once finished
+  bool finish()
+    requires(has_sink)
+  {
+    return sink->finish(buf, pos);
+  }
 
 private:
-  uint8_t *buf;
-  size_t len;
+  /// write n values from x with their bytes reversed
+  template <typename T> bool swapped_block(const T *x, size_t n) {
+    if (!checked || reserve(n * sizeof(T))) {
+      byteswap_block<sizeof(T)>(buf + pos, (const uint8_t *)x, n);
+      pos += n * sizeof(T);
+      return true;
+    } else if constexpr (!has_sink)
+      return false;
+
+    // the sink could not provide a big enough window, so fill each window in
+    // turn
+    while (n > 0) {
+      if (!reserve(sizeof(T))) {
+        // not even one element fits
+        uint8_t element[sizeof(T)];
+        byteswap_block<sizeof(T)>(element, (const uint8_t *)x, 1);
+        if (!bytes(element, sizeof(T)))
+          return false;
+        x++;
+        n--;
+        continue;
+      }
+
+      size_t count = std::min(n, (len - pos) / sizeof(T));
+      byteswap_block<sizeof(T)>(buf + pos, (const uint8_t *)x, count);
+      pos += count * sizeof(T);
+      x += count;
+      n -= count;
+    }
+    return true;
+  }
+
+  /// get a new window from the sink with (ideally) space for n bytes
+  bool next_window(size_t n)
+    requires(has_sink)
+  {
+    if (!sink->next(buf, len, pos, n))
+      return false;
+    done += pos;
+    pos = 0;
+    return len > 0;
+  }
+
+  /// make space for n bytes in the current window
+  bool reserve(size_t n) {
+    if (n <= len - pos)
+      return true;
+
+    if constexpr (has_sink)
+      return next_window(n) && n <= len;
+    else
+      return false;
+  }
+
+  uint8_t *buf = nullptr;
+  size_t len = 0;
   size_t pos = 0;
+  size_t done = 0;
+
+  struct Empty {};
+  [[no_unique_address]] std::conditional_t<has_sink, SinkT *, Empty> sink;
 };
 
 class MeasureBuf {
@@ -292,6 +1164,8 @@ public:
     return true;
   }
 
+  bool borrowed_bytes(const uint8_t *p, size_t n) { return bytes(p, n); }
+
   template <size_t size_p = 0, typename T> bool fixedint(const T &) {
     constexpr size_t size = size_p == 0 ? sizeof(T) : size_p;
     static_assert(size <= sizeof(T), "data size must be less than type size");
@@ -305,6 +1179,16 @@ public:
     return true;
   }
 
+  template <typename T> bool fixedints(const T *, size_t n) {
+    pos += n * sizeof(T);
+    return true;
+  }
+
+  template <typename T> bool natives(const T *, size_t n) {
+    pos += n * sizeof(T);
+    return true;
+  }
+
   template <typename T> bool varint(const T &x) {
     using U = std::make_unsigned_t<T>;
 
@@ -314,13 +1198,13 @@ public:
     else
       u = x;
 
-    // find required number of bytes
-    U remainder = u;
-    do {
-      remainder >>= 7;
-      pos++;
-    } while (remainder > 0);
+    pos += varint_length(u);
+    return true;
+  }
 
+  template <typename T> bool varints(const T *x, size_t n) {
+    for (size_t i = 0; i < n; i++)
+      varint(x[i]);
     return true;
   }
 
@@ -335,32 +1219,329 @@ private:
   size_t pos = 0;
 };
 
+/// the minimum number of bytes used by a value of T in a container, assuming
+/// that anything with a variable size reads something; see reads_nothing
+template <typename T> constexpr size_t min_size() {
+  if constexpr (std::is_arithmetic_v<T> && !std::is_same_v<T, bool>)
+    return sizeof(T);
+  else if constexpr (FixedSize<T>)
+    return fixed_size_info<T>().size;
+  else
+    return 1;
+}
+
+/// does parsing into T{} succeed without reading anything?
+///
+/// if so, every value of T in a container takes zero bytes, as the adapter
+/// had nothing to base a different decision on
+template <typename T> bool reads_nothing() {
+  static constexpr uint8_t empty[1] = {};
+  ParseBuf<true, void, BigEndian> pb(empty, 0);
+  T x{};
+  return pb(x);
+}
+
 } // namespace detail
 
+/// buffers which parse without storing the contents of containers
+///
+/// adapters for containers should call f.template discard<T>(n) rather than
+/// resizing and parsing n values of T
+template <typename F>
+concept Discarding = requires { requires F::discarding; };
+
+/// check that a container can hold n values of T, which take up at least
+/// min_input bytes, before it allocates space for them; see
+/// ParseBuf::check_length
+template <typename T, typename F>
+constexpr bool check_length(F &f, size_t n, size_t min_input) {
+  if constexpr (requires { f.template check_length<T>(n, min_input); })
+    return f.template check_length<T>(n, min_input);
+  else
+    return true;
+}
+
+/// check_length for n values of T, each of which takes at least one byte
+/// unless it has a fixed size, or parses without reading anything
+template <typename T, typename F>
+constexpr bool check_length(F &f, size_t n) {
+  constexpr size_t size = detail::min_size<T>();
+  size_t min_input = size > 0 && n > std::numeric_limits<size_t>::max() / size
+                         ? std::numeric_limits<size_t>::max()
+                         : n * size;
+  if (check_length<T>(f, n, min_input))
+    return true;
+  // only try the slow check once the length looks wrong
+  if constexpr (size == 1 && !std::is_arithmetic_v<T> && !detail::FixedSize<T>)
+    return detail::reads_nothing<T>() && check_length<T>(f, n, 0);
+  else
+    return false;
+}
+
+namespace detail {
+
+/// buffer which reads through data without storing the contents of
+/// containers
+///
+/// other values are parsed into a temporary provided by the caller, so that
+/// adapters which depend on them work as normal.
+///
+/// if validating is true, everything is checked as in ParseBuf, and booleans
+/// must be 0 or 1. Otherwise, values with a fixed size are skipped without
+/// looking at them.
+template <bool validating, bool checked = true, typename Format = BigEndian>
+class DiscardBuf {
+public:
+  static constexpr bool parsing = true;
+  static constexpr bool discarding = true;
+
+  DiscardBuf(const uint8_t *buf, size_t len) : buf(buf), len(len) {}
+
+  bool byte(uint8_t &x) {
+    return forward([&](auto &pb) { return pb.byte(x); });
+  }
+
+  bool boolean(bool &x) {
+    uint8_t b;
+    if (!byte(b) || (validating && b > 1))
+      return false;
+    x = b;
+    return true;
+  }
+
+  bool bytes(uint8_t *p, size_t n) {
+    return forward([&](auto &pb) { return pb.bytes(p, n); });
+  }
+
+  bool view(const uint8_t *&p, size_t n) {
+    return forward([&](auto &pb) { return pb.view(p, n); });
+  }
+
+  template <size_t size_p = 0, typename T> bool fixedint(T &x) {
+    return forward([&](auto &pb) { return pb.template fixedint<size_p>(x); });
+  }
+
+  template <typename T> bool native(T &x) {
+    return forward([&](auto &pb) { return pb.native(x); });
+  }
+
+  template <typename T> bool fixedints(T *x, size_t n) {
+    return forward([&](auto &pb) { return pb.fixedints(x, n); });
+  }
+
+  template <typename T> bool natives(T *x, size_t n) {
+    return forward([&](auto &pb) { return pb.natives(x, n); });
+  }
+
+  template <typename T> bool varint(T &x) {
+    return forward([&](auto &pb) { return pb.varint(x); });
+  }
+
+  template <typename T> bool varints(T *x, size_t n) {
+    return forward([&](auto &pb) { return pb.varints(x, n); });
+  }
+
+  /// read through n values of T, as stored in a container
+  template <typename T> bool discard(size_t n) {
+    if constexpr (std::is_arithmetic_v<T> && !std::is_same_v<T, bool>) {
+      // as with adapt_range, these are one block
+      return advance(n, sizeof(T));
+    } else if constexpr (!validating && FixedSize<T>) {
+      return advance(n, fixed_size_info<T>().size);
+    } else {
+      // reject lengths which could not possibly fit before checking each one
+      if (!cerealise::check_length<T>(*this, n))
+        return false;
+
+      for (size_t i = 0; i < n; i++) {
+        size_t start = pos;
+        T x{};
+        if (!(*this)(x))
+          return false;
+        // the rest would also read nothing, so don't spin through them
+        if (pos == start)
+          break;
+      }
+      return true;
+    }
+  }
+
+  template <typename T> bool operator()(T &x) {
+    using U = std::remove_cv_t<T>;
+    if constexpr (!validating && FixedSize<U>)
+      return advance(1, fixed_size_info<U>().size);
+    else if constexpr (checked && FixedSize<U>) {
+      constexpr size_t size = fixed_size_info<U>().size;
+      if (size > len - pos)
+        return false;
+
+      using Unchecked = DiscardBuf<validating, false, Format>;
+      Unchecked unchecked(buf + pos, size);
+      if (!Adapter<U>::template adapt<T, Unchecked>(x, unchecked))
+        return false;
+
+      pos += size;
+      return true;
+    } else
+      return Adapter<U>::template adapt<T, DiscardBuf>(x, *this);
+  }
+
+  /// check that n values of T taking up at least min_input bytes could be
+  /// read; nothing is allocated, so this only checks the input length
+  template <typename T> bool check_length(size_t, size_t min_input) const {
+    return !checked || min_input <= len - pos;
+  }
+
+  size_t bytes_read() const { return pos; }
+
+private:
+  /// skip n values of size bytes
+  bool advance(size_t n, size_t size) {
+    if (checked && size > 0 && n > (len - pos) / size)
+      return false;
+    pos += n * size;
+    return true;
+  }
+
+  /// run op on a ParseBuf for the rest of the input
+  template <typename Op> bool forward(Op op) {
+    ParseBuf<checked, void, Format> pb(buf + pos, len - pos);
+    if (!op(pb))
+      return false;
+    pos += pb.bytes_read();
+    return true;
+  }
+
+  const uint8_t *buf;
+  size_t len;
+  size_t pos = 0;
+};
+
+template <bool checked = true, typename Format = BigEndian>
+using ValidateBuf = DiscardBuf<true, checked, Format>;
+
+template <typename Format = BigEndian>
+using SkipBuf = DiscardBuf<false, true, Format>;
+
+/// parse/unparse n contiguous values starting at p
+///
+/// arithmetic types using the default adapters are handled as one block
+template <typename TT, typename F>
+constexpr bool adapt_range(TT *p, size_t n, F &f) {
+  using T = std::remove_cv_t<TT>;
+  if constexpr (std::is_integral_v<T> && !std::is_same_v<T, bool>)
+    return f.fixedints(p, n);
+  else if constexpr (std::is_floating_point_v<T>)
+    return f.natives(p, n);
+  else {
+    for (size_t i = 0; i < n; i++)
+      if (!f(p[i]))
+        return false;
+    return true;
+  }
+}
+
+} // namespace detail
+
+/// true if every value of T serialises to the same number of bytes, which is
+/// known at compile time
+///
+/// this is only true for types declared with FixedSizeTrait, which must also
+/// be default-constructible in a constant expression, with a constexpr
+/// adapter, and must not use varints or containers; otherwise this fails to
+/// compile. The layout of a declared type must not depend on its values;
+/// values of fixed-size types are parsed and unparsed without checking the
+/// bounds of each field.
+template <typename T> constexpr bool has_fixed_size_v = detail::FixedSize<T>;
+
+/// the number of bytes that any value of T serialises to
+///
+/// fails to compile if has_fixed_size_v<T> is false, for example if T contains
+/// a varint, string or vector
 template <typename T>
-bool parse(T &v, uint8_t *buf, size_t buf_len, size_t &bytes_read) {
-  detail::ParseBuf pb(buf, buf_len);
+  requires detail::FixedSize<T>
+constexpr size_t fixed_size_v = detail::fixed_size_info<T>().size;
+
+template <FormatPolicy Format, typename T>
+bool parse(T &v, const uint8_t *buf, size_t buf_len, size_t &bytes_read,
+           const ParseOptions &options) {
+  detail::ParseBuf<true, void, Format> pb(buf, buf_len, options);
 
   bool res = pb(v);
   bytes_read = pb.bytes_read();
   return res;
 }
 
-template <typename T>
+template <FormatPolicy Format, typename T>
+bool parse(T &v, std::span<const std::byte> buf, size_t &bytes_read,
+           const ParseOptions &options) {
+  return parse<Format>(v, (const uint8_t *)buf.data(), buf.size(), bytes_read,
+                       options);
+}
+
+template <FormatPolicy Format, typename T>
 bool unparse(const T &v, uint8_t *buf, size_t buf_len, size_t &bytes_written) {
-  detail::UnparseBuf pb(buf, buf_len);
+  detail::UnparseBuf<true, void, Format> pb(buf, buf_len);
 
   bool res = pb(v);
   bytes_written = pb.bytes_written();
   return res;
 }
 
-template <typename T> size_t measure(const T &v) {
-  detail::MeasureBuf pb;
+template <FormatPolicy Format, typename T, Source S>
+bool parse(T &v, S &source, size_t &bytes_read, const ParseOptions &options) {
+  detail::ParseBuf<true, S, Format> pb(source, options);
 
-  if (!pb(v))
-    return 0;
-  else
-    return pb.bytes_written();
+  bool res = pb(v);
+  pb.finish();
+  bytes_read = pb.bytes_read();
+  return res;
+}
+
+template <FormatPolicy Format, typename T, Sink S>
+bool unparse(const T &v, S &sink, size_t &bytes_written) {
+  detail::UnparseBuf<true, S, Format> pb(sink);
+
+  bool res = pb(v) && pb.finish();
+  bytes_written = pb.bytes_written();
+  return res;
+}
+
+template <typename T, FormatPolicy Format>
+bool validate(const uint8_t *buf, size_t buf_len, size_t &bytes_read) {
+  T v{};
+  detail::ValidateBuf<true, Format> pb(buf, buf_len);
+
+  bool res = pb(v);
+  bytes_read = pb.bytes_read();
+  return res;
+}
+
+template <typename T, FormatPolicy Format>
+bool skip(const uint8_t *buf, size_t buf_len, size_t &bytes_skipped) {
+  detail::SkipBuf<Format> pb(buf, buf_len);
+
+  bool res;
+  if constexpr (has_fixed_size_v<T>)
+    res = pb.template discard<T>(1);
+  else {
+    T v{};
+    res = pb(v);
+  }
+  bytes_skipped = pb.bytes_read();
+  return res;
+}
+
+template <FormatPolicy Format, typename T> size_t measure(const T &v) {
+  if constexpr (has_fixed_size_v<T>)
+    return fixed_size_v<T>;
+  else {
+    detail::MeasureBuf pb;
+
+    if (!pb(v))
+      return 0;
+    else
+      return pb.bytes_written();
+  }
 }
 } // namespace cerealise
@@ -0,0 +1,145 @@
+#pragma once
+#include "cerealise.hpp"
+#include "pmr.hpp"
+#include <vector>
+
+namespace cerealise {
+namespace detail {
+
+constexpr size_t delta_block_size = 128;
+
+/// read a width-bit little-endian value starting at bit bit_pos in p; p must
+/// have at least 9 bytes after the byte containing bit_pos
+inline uint64_t read_bits(const uint8_t *p, size_t bit_pos, unsigned width) {
+  size_t shift = bit_pos % 8;
+  uint64_t x = load_le64(p + bit_pos / 8) >> shift;
+  if (width + shift > 64)
+    x |= (uint64_t)p[bit_pos / 8 + 8] << (64 - shift);
+  return width == 64 ? x : x & (((uint64_t)1 << width) - 1);
+}
+
+/// or a width-bit value into p starting at bit bit_pos, as with read_bits
+inline void write_bits(uint8_t *p, size_t bit_pos, unsigned width,
+                       uint64_t x) {
+  size_t shift = bit_pos % 8;
+  for (size_t i = 0; i * 8 < width + shift; i++) {
+    unsigned bit = i * 8;
+    uint64_t part = bit >= shift ? x >> (bit - shift) : x << shift;
+    p[bit_pos / 8 + i] |= (uint8_t)part;
+  }
+}
+
+/// check the values after the count of a delta_packed vector, for buffers
+/// which do not store the contents of containers
+template <typename T, typename F> bool discard_delta_packed(F &f, size_t size) {
+  T first;
+  if (!f.varint(first))
+    return false;
+
+  for (size_t start = 1; start < size; start += delta_block_size) {
+    size_t count = std::min(size - start, delta_block_size);
+
+    uint8_t width;
+    if (!f.byte(width) || width > sizeof(T) * 8)
+      return false;
+    if (!f.template discard<uint8_t>((count * width + 7) / 8))
+      return false;
+  }
+  return true;
+}
+
+} // namespace detail
+
+/// parse/unparse a vector of integers using delta encoding, for sequences
+/// where consecutive values are close together, like timestamps or sorted
+/// IDs; call this from an adapter in place of f(v)
+///
+/// the format is a varint count, the first value as a varint, then the
+/// zigzag-encoded differences between consecutive values in blocks of 128.
+/// Each block is a byte containing the number of bits required for the
+/// largest difference in the block, followed by the differences packed
+/// with that many bits each (least significant first).
+///
+/// when parsing into a std::pmr::vector, see ParseOptions::resource
+template <typename F, typename V> bool delta_packed(F &f, V &v) {
+  using T = typename std::remove_cv_t<V>::value_type;
+  static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>,
+                "delta_packed requires a vector of integers");
+  using U = std::make_unsigned_t<T>;
+  using S = std::make_signed_t<T>;
+
+  size_t size = v.size();
+  if (!f.varint(size))
+    return false;
+
+  if constexpr (Discarding<F>)
+    return size == 0 || detail::discard_delta_packed<T>(f, size);
+
+  if constexpr (F::parsing) {
+    // the first value takes at least one byte, then each block has a width
+    size_t blocks = size == 0 ? 0
+                              : (size - 1 + detail::delta_block_size - 1) /
+                                    detail::delta_block_size;
+    if (!check_length<T>(f, size, size == 0 ? 0 : 1 + blocks))
+      return false;
+    detail::use_resource(v, f);
+    v.resize(size);
+  }
+
+  if (size == 0)
+    return true;
+
+  if (!f.varint(v[0]))
+    return false;
+
+  // packed block, with padding for read_bits
+  uint8_t packed[detail::delta_block_size * sizeof(T) + 16] = {};
+  U deltas[detail::delta_block_size];
+
+  for (size_t start = 1; start < size; start += detail::delta_block_size) {
+    size_t count = std::min(size - start, detail::delta_block_size);
+
+    uint8_t width;
+    if constexpr (!F::parsing) {
+      U all_bits = 0;
+      for (size_t i = 0; i < count; i++) {
+        U delta = (U)v[start + i] - (U)v[start + i - 1];
+        deltas[i] = detail::encode_zigzag((S)delta);
+        all_bits |= deltas[i];
+      }
+      width = std::bit_width(all_bits);
+    }
+
+    if (!f.byte(width))
+      return false;
+    if (width > sizeof(T) * 8)
+      return false;
+
+    size_t packed_len = (count * width + 7) / 8;
+
+    if constexpr (F::parsing) {
+      if (!f.bytes(packed, packed_len))
+        return false;
+
+      for (size_t i = 0; i < count; i++)
+        deltas[i] = (U)detail::read_bits(packed, i * width, width);
+
+      U prev = (U)v[start - 1];
+      for (size_t i = 0; i < count; i++) {
+        prev += (U)detail::decode_zigzag(deltas[i]);
+        v[start + i] = (T)prev;
+      }
+    } else {
+      std::fill_n(packed, packed_len, 0);
+      for (size_t i = 0; i < count; i++)
+        detail::write_bits(packed, i * width, width, deltas[i]);
+
+      if (!f.bytes(packed, packed_len))
+        return false;
+    }
+  }
+
+  return true;
+}
+
+} // namespace cerealise
@@ -0,0 +1,261 @@
+#pragma once
+#include "cerealise.hpp"
+#include "vector.hpp"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace cerealise {
+
+/// frame length prefix which is a varint
+struct VarintPrefix {
+  static constexpr size_t min_size = 1;
+  static constexpr size_t max_size =
+      detail::varint_length(std::numeric_limits<size_t>::max());
+
+  static constexpr size_t size(size_t n) { return detail::varint_length(n); }
+  static constexpr bool fits(size_t) { return true; }
+
+  template <typename F> static constexpr bool adapt(size_t &n, F &f) {
+    return f.varint(n);
+  }
+};
+
+/// VarintPrefix which unparse_framed pads to max_size with leading zero
+/// groups (0x80 bytes), rather than moving the body back once its size is
+/// known, unless the value has a fixed size
+///
+/// this is not canonical, and costs up to 9 bytes per frame; frames are read
+/// in the same way as with VarintPrefix
+struct PaddedVarintPrefix : VarintPrefix {
+  static constexpr bool padded = true;
+};
+
+/// frame length prefix which is a size_p-byte integer, in the byte order of
+/// the FormatPolicy used
+template <size_t size_p> struct FixedPrefix {
+  static_assert(size_p >= 1 && size_p <= sizeof(size_t),
+                "prefix size must be between 1 and sizeof(size_t)");
+
+  static constexpr size_t min_size = size_p;
+  static constexpr size_t max_size = size_p;
+
+  static constexpr size_t size(size_t) { return size_p; }
+  static constexpr bool fits(size_t n) {
+    if constexpr (size_p == sizeof(size_t))
+      return true;
+    else
+      return n >> (size_p * 8) == 0;
+  }
+
+  template <typename F> static constexpr bool adapt(size_t &n, F &f) {
+    return f.template fixedint<size_p>(n);
+  }
+};
+
+/// describes the length prefix of a frame; see VarintPrefix and FixedPrefix
+///
+/// size(n) is the size of the prefix for an n-byte body, which is between
+/// min_size and max_size, and fits(n) is false if n can not be represented.
+/// adapt(n, f) parses or unparses n like an Adapter. Prefixes where padded is
+/// true must be varints, as they are padded with 0x80 bytes.
+template <typename P>
+concept FramePrefix = requires(size_t n) {
+  { P::min_size } -> std::convertible_to<size_t>;
+  { P::max_size } -> std::convertible_to<size_t>;
+  { P::size(n) } -> std::convertible_to<size_t>;
+  { P::fits(n) } -> std::convertible_to<bool>;
+};
+
+/// serialise v into buf as a frame: a length prefix followed by the
+/// serialised value
+///
+/// this is done without measuring v first, so space for the longest possible
+/// prefix is left before the body, which is moved back if the prefix turns
+/// out to be shorter (unless T has a fixed size, in which case the prefix
+/// size is known, or with PaddedVarintPrefix). If buf does not have space
+/// for the longest prefix and the body, v is measured first instead.
+///
+/// bytes_written: the size of the frame, including the prefix
+///
+/// returns false if buf is too small, the length does not fit in the prefix,
+/// or serialisation fails
+template <FramePrefix Prefix = VarintPrefix, FormatPolicy Format = BigEndian,
+          typename T>
+bool unparse_framed(const T &v, uint8_t *buf, size_t buf_len,
+                    size_t &bytes_written);
+
+/// serialise v as a frame, appending to buf
+///
+/// returns true if serialisation was successful; buf is not modified if
+/// serialisation fails
+template <FramePrefix Prefix = VarintPrefix, FormatPolicy Format = BigEndian,
+          typename T>
+bool unparse_framed(const T &v, std::vector<uint8_t> &buf,
+                    size_t &bytes_written);
+
+/// cursor which returns complete frames from a receive buffer
+///
+/// frames are returned in order by next(). When the rest of the buffer does
+/// not contain a complete frame, needed() is the number of bytes which must
+/// be added (at least) before it does, and consumed() is the number of bytes
+/// which were used by complete frames, and can be dropped from the buffer.
+///
+/// frames with a body longer than max_body are an error, so that a corrupt
+/// or hostile prefix is noticed before waiting for the body.
+template <FramePrefix Prefix = VarintPrefix, FormatPolicy Format = BigEndian>
+class FrameReader {
+public:
+  FrameReader(const uint8_t *buf, size_t len,
+              size_t max_body = std::numeric_limits<size_t>::max())
+      : buf(buf), len(len), max_body(max_body) {}
+
+  /// if the next frame is complete, point body at its contents, move past it
+  /// and return true; otherwise return false, and check error()
+  bool next(const uint8_t *&body, size_t &body_len) {
+    if (failed)
+      return false;
+
+    size_t available = len - pos;
+    detail::ParseBuf<true, void, Format> pb(buf + pos, available);
+    size_t n;
+    if (!Prefix::adapt(n, pb)) {
+      // a prefix which is still invalid at the maximum size is corrupt,
+      // otherwise it has not all arrived yet
+      if (available >= Prefix::max_size)
+        failed = true;
+      else if (available < Prefix::min_size)
+        need = Prefix::min_size - available;
+      else
+        need = 1;
+      return false;
+    }
+
+    if (n > max_body) {
+      failed = true;
+      return false;
+    }
+
+    size_t prefix_len = pb.bytes_read();
+    if (n > available - prefix_len) {
+      need = n - (available - prefix_len);
+      return false;
+    }
+
+    body = buf + pos + prefix_len;
+    body_len = n;
+    pos += prefix_len + n;
+    need = 0;
+    return true;
+  }
+
+  /// the number of bytes needed to complete the next frame, after next()
+  /// returns false without an error
+  size_t needed() const { return need; }
+
+  /// the number of bytes at the start of the buffer used by complete frames
+  size_t consumed() const { return pos; }
+
+  /// true if the data is not a valid frame, or the body is too long
+  bool error() const { return failed; }
+
+private:
+  const uint8_t *buf;
+  size_t len;
+  size_t max_body;
+
+  size_t pos = 0;
+  size_t need = 0;
+  bool failed = false;
+};
+
+namespace detail {
+/// the number of bytes to leave for the prefix before unparsing the body
+template <typename Prefix, typename T> constexpr size_t frame_prefix_width() {
+  if constexpr (has_fixed_size_v<T>)
+    return Prefix::size(fixed_size_v<T>);
+  else
+    return Prefix::max_size;
+}
+
+template <typename Prefix>
+concept PaddedPrefix = requires { requires Prefix::padded; };
+
+/// the size of the prefix for an n-byte body, when width bytes were left
+template <typename Prefix> constexpr size_t frame_prefix_len(size_t width,
+                                                             size_t n) {
+  if constexpr (PaddedPrefix<Prefix>)
+    return width;
+  else
+    return Prefix::size(n);
+}
+
+/// write the prefix for an n-byte body to p, padded to width bytes
+template <typename Prefix, typename Format>
+bool unparse_frame_prefix(uint8_t *p, size_t width, size_t n) {
+  size_t padding = width - Prefix::size(n);
+  std::fill_n(p, padding, 0x80);
+
+  UnparseBuf<true, void, Format> pb(p + padding, width - padding);
+  return Prefix::adapt(n, pb);
+}
+} // namespace detail
+
+template <FramePrefix Prefix, FormatPolicy Format, typename T>
+bool unparse_framed(const T &v, uint8_t *buf, size_t buf_len,
+                    size_t &bytes_written) {
+  constexpr size_t width = detail::frame_prefix_width<Prefix, T>();
+  size_t body_len;
+  if (width > buf_len ||
+      !unparse<Format>(v, buf + width, buf_len - width, body_len)) {
+    // the frame may still fit with a shorter prefix
+    if constexpr (!detail::PaddedPrefix<Prefix> && width > Prefix::min_size) {
+      body_len = measure(v);
+      size_t prefix_len = Prefix::size(body_len);
+      if (!Prefix::fits(body_len) || prefix_len > buf_len ||
+          body_len > buf_len - prefix_len ||
+          !unparse<Format>(v, buf + prefix_len, body_len, body_len))
+        return false;
+
+      bytes_written = prefix_len + body_len;
+      return detail::unparse_frame_prefix<Prefix, Format>(buf, prefix_len,
+                                                          body_len);
+    } else
+      return false;
+  }
+  if (!Prefix::fits(body_len))
+    return false;
+
+  size_t prefix_len = detail::frame_prefix_len<Prefix>(width, body_len);
+  if (prefix_len < width)
+    std::memmove(buf + prefix_len, buf + width, body_len);
+
+  bytes_written = prefix_len + body_len;
+  return detail::unparse_frame_prefix<Prefix, Format>(buf, prefix_len,
+                                                      body_len);
+}
+
+template <FramePrefix Prefix, FormatPolicy Format, typename T>
+bool unparse_framed(const T &v, std::vector<uint8_t> &buf,
+                    size_t &bytes_written) {
+  constexpr size_t width = detail::frame_prefix_width<Prefix, T>();
+  size_t old_size = buf.size();
+  buf.resize(old_size + width);
+
+  size_t body_len;
+  if (!unparse<Format>(v, buf, body_len) || !Prefix::fits(body_len)) {
+    buf.resize(old_size);
+    return false;
+  }
+
+  size_t prefix_len = detail::frame_prefix_len<Prefix>(width, body_len);
+  buf.erase(buf.begin() + old_size + prefix_len,
+            buf.begin() + old_size + width);
+
+  bytes_written = prefix_len + body_len;
+  return detail::unparse_frame_prefix<Prefix, Format>(buf.data() + old_size,
+                                                      prefix_len, body_len);
+}
+
+} // namespace cerealise
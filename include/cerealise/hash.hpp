@@ -0,0 +1,173 @@
+#pragma once
+#include "cerealise.hpp"
+
+namespace cerealise {
+
+/// hash the serialised form of v, without writing it to memory
+///
+/// the result is the XXH64 hash (with the given seed) of the bytes that
+/// unparse<Format> would write for v
+///
+/// returns 0 in case of error
+template <FormatPolicy Format = BigEndian, typename T>
+uint64_t hash(const T &v, uint64_t seed = 0);
+
+namespace detail {
+
+/// streaming implementation of XXH64
+class XXHash64 {
+public:
+  XXHash64(uint64_t seed = 0)
+      : acc{seed + prime_1 + prime_2, seed + prime_2, seed, seed - prime_1},
+        seed(seed) {}
+
+  void update(const uint8_t *p, size_t n) {
+    total_len += n;
+
+    if (buffered + n < stripe_size) {
+      std::copy_n(p, n, buffer + buffered);
+      buffered += n;
+      return;
+    }
+
+    if (buffered) {
+      size_t fill = stripe_size - buffered;
+      std::copy_n(p, fill, buffer + buffered);
+      stripe(buffer);
+      p += fill;
+      n -= fill;
+      buffered = 0;
+    }
+
+    for (; n >= stripe_size; p += stripe_size, n -= stripe_size)
+      stripe(p);
+
+    std::copy_n(p, n, buffer);
+    buffered = n;
+  }
+
+  uint64_t digest() const {
+    uint64_t h;
+    if (total_len >= stripe_size) {
+      h = std::rotl(acc[0], 1) + std::rotl(acc[1], 7) + std::rotl(acc[2], 12) +
+          std::rotl(acc[3], 18);
+      for (uint64_t a : acc)
+        h = merge_round(h, a);
+    } else
+      h = seed + prime_5;
+
+    h += total_len;
+
+    const uint8_t *p = buffer, *end = buffer + buffered;
+    for (; end - p >= 8; p += 8) {
+      h ^= round(0, load_le<uint64_t>(p));
+      h = std::rotl(h, 27) * prime_1 + prime_4;
+    }
+    if (end - p >= 4) {
+      h ^= (uint64_t)load_le<uint32_t>(p) * prime_1;
+      h = std::rotl(h, 23) * prime_2 + prime_3;
+      p += 4;
+    }
+    for (; p != end; p++) {
+      h ^= *p * prime_5;
+      h = std::rotl(h, 11) * prime_1;
+    }
+
+    h ^= h >> 33;
+    h *= prime_2;
+    h ^= h >> 29;
+    h *= prime_3;
+    h ^= h >> 32;
+    return h;
+  }
+
+private:
+  static constexpr uint64_t prime_1 = 0x9e3779b185ebca87;
+  static constexpr uint64_t prime_2 = 0xc2b2ae3d27d4eb4f;
+  static constexpr uint64_t prime_3 = 0x165667b19e3779f9;
+  static constexpr uint64_t prime_4 = 0x85ebca77c2b2ae63;
+  static constexpr uint64_t prime_5 = 0x27d4eb2f165667c5;
+
+  static constexpr size_t stripe_size = 32;
+
+  template <typename U> static U load_le(const uint8_t *p) {
+    return load_int<std::endian::little, sizeof(U), U>(p);
+  }
+
+  static uint64_t round(uint64_t acc, uint64_t input) {
+    acc += input * prime_2;
+    return std::rotl(acc, 31) * prime_1;
+  }
+
+  static uint64_t merge_round(uint64_t h, uint64_t acc) {
+    h ^= round(0, acc);
+    return h * prime_1 + prime_4;
+  }
+
+  void stripe(const uint8_t *p) {
+    for (size_t i = 0; i < 4; i++)
+      acc[i] = round(acc[i], load_le<uint64_t>(p + i * 8));
+  }
+
+  uint64_t acc[4];
+  uint64_t seed;
+  uint64_t total_len = 0;
+  uint8_t buffer[stripe_size];
+  size_t buffered = 0;
+};
+
+/// ReferenceSink which hashes everything written to it
+///
+/// small values are collected in a staging buffer, and large blocks are
+/// hashed where they are
+class HashSink {
+public:
+  HashSink(uint64_t seed) : hasher(seed) {}
+
+  size_t reference_threshold() const { return 64; }
+
+  bool next(uint8_t *&buf, size_t &len, size_t written, size_t) {
+    hasher.update(staging, written);
+    buf = staging;
+    len = sizeof(staging);
+    return true;
+  }
+
+  bool reference(uint8_t *&buf, size_t &len, size_t written, const uint8_t *p,
+                 size_t n) {
+    hasher.update(staging, written);
+    hasher.update(p, n);
+    buf = staging;
+    len = sizeof(staging);
+    return true;
+  }
+
+  bool finish(uint8_t *, size_t written) {
+    hasher.update(staging, written);
+    return true;
+  }
+
+  uint64_t digest() const { return hasher.digest(); }
+
+private:
+  XXHash64 hasher;
+  uint8_t staging[512];
+};
+
+/// buffer which hashes the serialised form of values, like MeasureBuf
+template <typename Format = BigEndian>
+using HashBuf = UnparseBuf<true, HashSink, Format>;
+
+} // namespace detail
+
+template <FormatPolicy Format, typename T>
+uint64_t hash(const T &v, uint64_t seed) {
+  detail::HashSink sink(seed);
+  detail::HashBuf<Format> pb(sink);
+
+  if (!(pb(v) && pb.finish()))
+    return 0;
+  return sink.digest();
+}
+
+} // namespace cerealise
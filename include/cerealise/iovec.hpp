@@ -0,0 +1,98 @@
+#pragma once
+#include "cerealise.hpp"
+#include <algorithm>
+#include <sys/uio.h>
+#include <vector>
+
+namespace cerealise {
+
+/// ReferenceSink which produces a list of iovecs for writev/sendmsg
+///
+/// blocks passed to borrowed_bytes() which are at least reference_threshold
+/// bytes long (the contents of strings, string_views, spans and
+/// std::vector<uint8_t>) are referred to directly, so the value being
+/// unparsed must outlive the iovecs. Everything else is written to a staging
+/// buffer owned by the sink.
+///
+/// the sink can be reused by calling clear(), which keeps allocated memory.
+class IovecSink {
+public:
+  IovecSink(size_t reference_threshold = 256)
+      : threshold(reference_threshold) {}
+
+  size_t reference_threshold() const { return threshold; }
+
+  bool next(uint8_t *&buf, size_t &len, size_t written, size_t n) {
+    used += written;
+
+    static constexpr size_t min_size = 256;
+    if (used + n > staging.size())
+      staging.resize(std::max({used + n, staging.size() * 2, min_size}));
+
+    buf = staging.data() + used;
+    len = staging.size() - used;
+    return true;
+  }
+
+  bool reference(uint8_t *&buf, size_t &len, size_t written, const uint8_t *p,
+                 size_t n) {
+    used += written;
+    end_segment();
+    segments.push_back({p, 0, n});
+
+    buf = staging.data() + used;
+    len = staging.size() - used;
+    return true;
+  }
+
+  bool finish(uint8_t *, size_t written) {
+    used += written;
+    end_segment();
+
+    // staging may have moved while unparsing, so segments in it are only
+    // turned into pointers at the end
+    iov.clear();
+    for (auto &segment : segments) {
+      const uint8_t *base =
+          segment.p ? segment.p : staging.data() + segment.offset;
+      iov.push_back({(void *)base, segment.len});
+    }
+    return true;
+  }
+
+  /// the data written by unparse, valid after unparse succeeds
+  const std::vector<iovec> &iovecs() const { return iov; }
+
+  /// remove all data, keeping allocated memory
+  void clear() {
+    used = 0;
+    segment_start = 0;
+    segments.clear();
+    iov.clear();
+  }
+
+private:
+  /// add any data in staging since the last segment as a new segment
+  void end_segment() {
+    if (used > segment_start)
+      segments.push_back({nullptr, segment_start, used - segment_start});
+    segment_start = used;
+  }
+
+  struct Segment {
+    const uint8_t *p; // nullptr for data in staging
+    size_t offset;    // offset in staging
+    size_t len;
+  };
+
+  size_t threshold;
+
+  std::vector<uint8_t> staging;
+  size_t used = 0;
+  size_t segment_start = 0;
+
+  std::vector<Segment> segments;
+  std::vector<iovec> iov;
+};
+
+} // namespace cerealise
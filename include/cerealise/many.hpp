@@ -0,0 +1,262 @@
+#pragma once
+#include "cerealise.hpp"
+#include "vector.hpp"
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace cerealise {
+
+/// runs the work of the functions below, so that an existing thread pool can
+/// be used rather than starting threads for each call; pass one in place of
+/// n_threads
+///
+/// concurrency() is the number of tasks worth running at once, and
+/// run(n, task) calls task(i) once for each i in [0, n), possibly on other
+/// threads, and returns once they have all finished
+template <typename E>
+concept Executor =
+    requires(E &e, size_t n, const std::function<void(size_t)> &task) {
+      { e.concurrency() } -> std::convertible_to<size_t>;
+      e.run(n, task);
+    };
+
+/// Executor which starts a thread for each task but the first, which is run
+/// on the calling thread; this is used when a number of threads is given
+class ThreadExecutor {
+public:
+  /// n_threads: the concurrency, or 0 for one per core
+  explicit ThreadExecutor(unsigned n_threads = 0)
+      : n_threads(n_threads ? n_threads
+                            : std::max(std::thread::hardware_concurrency(),
+                                       1u)) {}
+
+  size_t concurrency() const { return n_threads; }
+
+  template <typename Task> void run(size_t n, Task &&task) {
+    std::vector<std::thread> threads;
+    threads.reserve(n > 0 ? n - 1 : 0);
+    for (size_t i = 1; i < n; i++)
+      threads.emplace_back([&task, i] { task(i); });
+
+    if (n > 0)
+      task(0);
+
+    for (auto &thread : threads)
+      thread.join();
+  }
+
+private:
+  unsigned n_threads;
+};
+
+/// serialise the n values at values one after another, appending to buf,
+/// using up to n_threads threads (0 for one per core)
+///
+/// the values are measured in parallel, their sizes are summed to find where
+/// each one goes, and then each thread serialises a run of values into its
+/// own part of buf. The output is the same as calling unparse for each value
+/// in turn.
+///
+/// offsets: set to n+1 positions in buf; value i is at [offsets[i],
+/// offsets[i+1])
+///
+/// returns true if serialisation was successful; buf is not modified if
+/// serialisation fails
+template <FormatPolicy Format = BigEndian, typename T>
+bool unparse_many(const T *values, size_t n, std::vector<uint8_t> &buf,
+                  std::vector<size_t> &offsets, unsigned n_threads = 0);
+
+/// unparse_many, running on executor
+template <FormatPolicy Format = BigEndian, typename T, Executor E>
+bool unparse_many(const T *values, size_t n, std::vector<uint8_t> &buf,
+                  std::vector<size_t> &offsets, E &executor);
+
+/// parse n values from buf, which were serialised one after another, using
+/// up to n_threads threads (0 for one per core)
+///
+/// offsets: n+1 positions in buf, as produced by unparse_many or
+/// index_many; value i must take up exactly [offsets[i], offsets[i+1])
+///
+/// options apply to each value separately
+///
+/// returns true if parsing was successful
+template <FormatPolicy Format = BigEndian, typename T>
+bool parse_many(T *values, size_t n, const uint8_t *buf, size_t buf_len,
+                const size_t *offsets, unsigned n_threads = 0,
+                const ParseOptions &options = {});
+
+/// parse_many, running on executor
+template <FormatPolicy Format = BigEndian, typename T, Executor E>
+bool parse_many(T *values, size_t n, const uint8_t *buf, size_t buf_len,
+                const size_t *offsets, E &executor,
+                const ParseOptions &options = {});
+
+/// find the positions of n values of type T serialised one after another in
+/// buf, for parse_many, using skip
+///
+/// offsets: set to n+1 positions, as with unparse_many
+///
+/// returns false if buf does not contain n valid values
+template <typename T, FormatPolicy Format = BigEndian>
+bool index_many(const uint8_t *buf, size_t buf_len, size_t n,
+                std::vector<size_t> &offsets);
+
+namespace detail {
+/// the smallest number of values given to each thread; smaller batches are
+/// not worth starting a thread for
+inline constexpr size_t many_min_per_thread = 256;
+
+/// the number of runs to split n values into, with at most one per task
+/// that executor can run at once
+template <typename E> size_t many_runs(size_t n, E &executor) {
+  size_t concurrency = std::max<size_t>(executor.concurrency(), 1);
+  return std::clamp<size_t>(n / many_min_per_thread, 1, concurrency);
+}
+
+/// split [0, n) into n_runs runs, and call f(run, begin, end) for each run
+/// in parallel on executor
+template <typename E, typename F>
+void parallel_runs(E &executor, size_t n, size_t n_runs, F &&f) {
+  size_t per_run = (n + n_runs - 1) / n_runs;
+  executor.run(n_runs, [&f, per_run, n](size_t run) {
+    f(run, std::min(n, run * per_run), std::min(n, (run + 1) * per_run));
+  });
+}
+
+/// true if all runs succeeded
+inline bool all_runs_ok(const std::vector<uint8_t> &run_ok) {
+  return std::find(run_ok.begin(), run_ok.end(), 0) == run_ok.end();
+}
+} // namespace detail
+
+template <FormatPolicy Format, typename T>
+bool unparse_many(const T *values, size_t n, std::vector<uint8_t> &buf,
+                  std::vector<size_t> &offsets, unsigned n_threads) {
+  ThreadExecutor executor(n_threads);
+  return unparse_many<Format>(values, n, buf, offsets, executor);
+}
+
+template <FormatPolicy Format, typename T, Executor E>
+bool unparse_many(const T *values, size_t n, std::vector<uint8_t> &buf,
+                  std::vector<size_t> &offsets, E &executor) {
+  size_t old_size = buf.size();
+  size_t n_runs = detail::many_runs(n, executor);
+  offsets.resize(n + 1);
+
+  if constexpr (has_fixed_size_v<T>) {
+    for (size_t i = 0; i <= n; i++)
+      offsets[i] = old_size + i * fixed_size_v<T>;
+  } else {
+    // measure each value into offsets, and total up each run
+    std::vector<size_t> run_start(n_runs + 1, 0);
+    std::vector<uint8_t> run_ok(n_runs, 1);
+    detail::parallel_runs(
+        executor, n, n_runs, [&](size_t run, size_t begin, size_t end) {
+          size_t total = 0;
+          for (size_t i = begin; i < end; i++) {
+            size_t size = measure<Format>(values[i]);
+            if (size == 0) {
+              run_ok[run] = 0;
+              return;
+            }
+            offsets[i] = size;
+            total += size;
+          }
+          run_start[run] = total;
+        });
+    if (!detail::all_runs_ok(run_ok))
+      return false;
+
+    // then the sizes in each run can be replaced by offsets independently
+    std::exclusive_scan(run_start.begin(), run_start.end(), run_start.begin(),
+                        old_size);
+    detail::parallel_runs(
+        executor, n, n_runs, [&](size_t run, size_t begin, size_t end) {
+          size_t pos = run_start[run];
+          for (size_t i = begin; i < end; i++)
+            pos += std::exchange(offsets[i], pos);
+        });
+    offsets[n] = run_start[n_runs];
+  }
+
+  buf.resize(offsets[n]);
+
+  std::vector<uint8_t> run_ok(n_runs, 1);
+  detail::parallel_runs(
+      executor, n, n_runs, [&](size_t run, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+          size_t size = offsets[i + 1] - offsets[i], written;
+          if (!unparse<Format>(values[i], buf.data() + offsets[i], size,
+                               written) ||
+              written != size) {
+            run_ok[run] = 0;
+            return;
+          }
+        }
+      });
+
+  if (!detail::all_runs_ok(run_ok)) {
+    buf.resize(old_size);
+    return false;
+  }
+  return true;
+}
+
+template <FormatPolicy Format, typename T>
+bool parse_many(T *values, size_t n, const uint8_t *buf, size_t buf_len,
+                const size_t *offsets, unsigned n_threads,
+                const ParseOptions &options) {
+  ThreadExecutor executor(n_threads);
+  return parse_many<Format>(values, n, buf, buf_len, offsets, executor,
+                            options);
+}
+
+template <FormatPolicy Format, typename T, Executor E>
+bool parse_many(T *values, size_t n, const uint8_t *buf, size_t buf_len,
+                const size_t *offsets, E &executor,
+                const ParseOptions &options) {
+  for (size_t i = 0; i < n; i++)
+    if (offsets[i] > offsets[i + 1])
+      return false;
+  if (offsets[n] > buf_len)
+    return false;
+
+  size_t n_runs = detail::many_runs(n, executor);
+  std::vector<uint8_t> run_ok(n_runs, 1);
+  detail::parallel_runs(
+      executor, n, n_runs, [&](size_t run, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+          size_t size = offsets[i + 1] - offsets[i], read;
+          if (!parse<Format>(values[i], buf + offsets[i], size, read,
+                             options) ||
+              read != size) {
+            run_ok[run] = 0;
+            return;
+          }
+        }
+      });
+
+  return detail::all_runs_ok(run_ok);
+}
+
+template <typename T, FormatPolicy Format>
+bool index_many(const uint8_t *buf, size_t buf_len, size_t n,
+                std::vector<size_t> &offsets) {
+  offsets.resize(n + 1);
+  size_t pos = 0;
+  for (size_t i = 0; i < n; i++) {
+    offsets[i] = pos;
+    size_t skipped;
+    if (!skip<T, Format>(buf + pos, buf_len - pos, skipped))
+      return false;
+    pos += skipped;
+  }
+  offsets[n] = pos;
+  return true;
+}
+
+} // namespace cerealise
@@ -0,0 +1,315 @@
+#pragma once
+#include "cerealise.hpp"
+#include "framing.hpp"
+#include "stream.hpp"
+#include "vector.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fcntl.h>
+#include <limits>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace cerealise {
+namespace detail {
+
+/// a whole file mapped read-only into memory
+class MappedFile {
+public:
+  MappedFile() = default;
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  ~MappedFile() { close(); }
+
+  /// map the file at path, replacing any previous mapping; returns false on
+  /// error
+  bool open(const char *path) {
+    close();
+
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+      return false;
+
+    struct stat st;
+    bool res = fstat(fd, &st) == 0;
+    // empty files can not be mapped, but are valid
+    if (res && st.st_size > 0) {
+      void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p == MAP_FAILED)
+        res = false;
+      else {
+        map = (const uint8_t *)p;
+        len = st.st_size;
+      }
+    }
+
+    ::close(fd);
+    return res;
+  }
+
+  void close() {
+    if (map)
+      munmap((void *)map, len);
+    map = nullptr;
+    len = 0;
+  }
+
+  const uint8_t *data() const { return map; }
+  size_t size() const { return len; }
+
+private:
+  const uint8_t *map = nullptr;
+  size_t len = 0;
+};
+
+/// the smallest size of the mapping made by MappedFileSink
+inline constexpr size_t mapped_sink_min_size = 1 << 20;
+
+/// the contents of an index file written by RecordFile::save_index
+struct RecordIndex {
+  uint64_t file_size;
+  std::vector<uint64_t> offsets;
+
+  template <typename T, typename F> static bool cerealise(T &v, F &f) {
+    return f(v.file_size) && f(v.offsets);
+  }
+};
+
+} // namespace detail
+
+/// read-only access to a file of records written with unparse_framed, mapped
+/// into memory so that records are parsed in place without reading them into
+/// a buffer first
+///
+/// the position of each record is found with build_index, or loaded from a
+/// file written by save_index. The file must not be changed while it is open.
+template <FramePrefix Prefix = VarintPrefix, FormatPolicy Format = BigEndian>
+class RecordFile {
+public:
+  /// map the file at path; returns false on error
+  ///
+  /// any previous index is discarded
+  bool open(const char *path) {
+    offsets.clear();
+    return file.open(path);
+  }
+
+  void close() {
+    offsets.clear();
+    file.close();
+  }
+
+  /// find the position of each record by reading through the file
+  ///
+  /// returns false if the file ends part way through a record, or contains an
+  /// invalid prefix or a record longer than max_body
+  bool build_index(size_t max_body = std::numeric_limits<size_t>::max()) {
+    offsets.clear();
+
+    FrameReader<Prefix, Format> reader(file.data(), file.size(), max_body);
+    const uint8_t *body;
+    size_t body_len;
+    for (size_t pos = 0; reader.next(body, body_len);
+         pos = reader.consumed())
+      offsets.push_back(pos);
+
+    if (reader.error() || reader.consumed() != file.size()) {
+      offsets.clear();
+      return false;
+    }
+    return true;
+  }
+
+  /// write the index to a file at path, for load_index
+  bool save_index(const char *path) const {
+    FILE *out = fopen(path, "wb");
+    if (!out)
+      return false;
+
+    detail::RecordIndex index{file.size(), offsets};
+    uint8_t buf[4096];
+    FileSink sink(out, buf, sizeof(buf));
+    size_t len;
+    bool res = unparse<LittleEndian>(index, sink, len) && sink.flush();
+    return fclose(out) == 0 && res;
+  }
+
+  /// load an index written by save_index
+  ///
+  /// returns false if it can not be read, or does not match this file
+  bool load_index(const char *path) {
+    offsets.clear();
+
+    detail::MappedFile index_file;
+    detail::RecordIndex index;
+    size_t len;
+    if (!index_file.open(path) ||
+        !cerealise::parse<LittleEndian>(index, index_file.data(),
+                                        index_file.size(), len) ||
+        len != index_file.size() || index.file_size != file.size())
+      return false;
+
+    // records are checked when they are read, but must be in order so that
+    // each one is at least within the file
+    for (size_t i = 0; i < index.offsets.size(); i++)
+      if (index.offsets[i] >= file.size() ||
+          (i > 0 && index.offsets[i] <= index.offsets[i - 1]))
+        return false;
+
+    offsets = std::move(index.offsets);
+    return true;
+  }
+
+  /// the number of records in the index
+  size_t size() const { return offsets.size(); }
+
+  /// point body at the contents of record i in the mapped file
+  ///
+  /// returns false if i is out of range, or the record is invalid
+  bool record(size_t i, const uint8_t *&body, size_t &body_len) const {
+    if (i >= offsets.size())
+      return false;
+    FrameReader<Prefix, Format> reader(file.data() + offsets[i],
+                                       file.size() - offsets[i]);
+    return reader.next(body, body_len);
+  }
+
+  /// parse record i into v, which must use the whole record
+  template <typename T>
+  bool parse(size_t i, T &v, const ParseOptions &options = {}) const {
+    const uint8_t *body;
+    size_t body_len, len;
+    return record(i, body, body_len) &&
+           cerealise::parse<Format>(v, body, body_len, len, options) &&
+           len == body_len;
+  }
+
+private:
+  detail::MappedFile file;
+  std::vector<uint64_t> offsets;
+};
+
+/// Sink which writes into a file mapped into memory, growing the file and the
+/// mapping as it fills up, so that data does not pass through a separate
+/// buffer and write()
+///
+/// the file is grown by at least doubling its size with ftruncate (so it is
+/// sparse until written) and remapped with mremap where available. Each time
+/// the file grows, writing back the data so far is started with msync.
+///
+/// as with BufferedSink, data is kept between calls to unparse; call close()
+/// to trim the file to the data written, or sync() to wait for the data to
+/// reach the file first. As with any shared mapping, running out of disk
+/// space while writing raises SIGBUS.
+class MappedFileSink {
+public:
+  MappedFileSink() = default;
+  MappedFileSink(const MappedFileSink &) = delete;
+  MappedFileSink &operator=(const MappedFileSink &) = delete;
+  ~MappedFileSink() { close(); }
+
+  /// create or truncate the file at path; returns false on error
+  bool open(const char *path) {
+    if (!close())
+      return false;
+    fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    return fd >= 0;
+  }
+
+  bool next(uint8_t *&buf, size_t &len, size_t written, size_t n) {
+    used += written;
+
+    if (n > capacity - used) {
+      size_t new_capacity =
+          std::max({capacity * 2, used + n, detail::mapped_sink_min_size});
+      if (!grow(new_capacity))
+        return false;
+    }
+
+    buf = map + used;
+    len = capacity - used;
+    return true;
+  }
+
+  bool finish(uint8_t *, size_t written) {
+    used += written;
+    return true;
+  }
+
+  /// start writing back the data written so far, without waiting
+  bool flush() { return msync_used(MS_ASYNC); }
+
+  /// write back the data written so far, and wait for it to finish
+  bool sync() { return msync_used(MS_SYNC); }
+
+  /// unmap the file, trim it to the size of the data written, and close it
+  ///
+  /// this does nothing if the file is not open
+  bool close() {
+    if (fd < 0)
+      return true;
+
+    bool res = true;
+    if (map)
+      res = munmap(map, capacity) == 0;
+    res = ftruncate(fd, used) == 0 && res;
+    res = ::close(fd) == 0 && res;
+
+    fd = -1;
+    map = nullptr;
+    capacity = 0;
+    used = 0;
+    return res;
+  }
+
+  /// the number of bytes written to the file
+  size_t size() const { return used; }
+
+private:
+  bool grow(size_t new_capacity) {
+    if (fd < 0 || ftruncate(fd, new_capacity) != 0)
+      return false;
+
+    // the data so far will not be written again, so start writing it back
+    if (!flush())
+      return false;
+
+    void *p;
+    if (!map)
+      p = mmap(nullptr, new_capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+               0);
+    else {
+#if defined(__linux__)
+      p = mremap(map, capacity, new_capacity, MREMAP_MAYMOVE);
+#else
+      if (munmap(map, capacity) != 0)
+        return false;
+      map = nullptr;
+      capacity = 0;
+      p = mmap(nullptr, new_capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+               0);
+#endif
+    }
+    if (p == MAP_FAILED)
+      return false;
+
+    map = (uint8_t *)p;
+    capacity = new_capacity;
+    return true;
+  }
+
+  bool msync_used(int flags) {
+    if (!map || used == 0)
+      return true;
+    return msync(map, used, flags) == 0;
+  }
+
+  int fd = -1;
+  uint8_t *map = nullptr;
+  size_t capacity = 0;
+  size_t used = 0;
+};
+
+} // namespace cerealise
@@ -5,7 +5,8 @@
 namespace cerealise {
 
 template <typename T> struct Adapter<std::optional<T>> {
-  template <typename TT, typename F> static bool adapt(TT &v, F &f) {
+  template <typename TT, typename F>
+  static constexpr bool adapt(TT &v, F &f) {
     if constexpr (F::parsing) {
       bool has_value;
       if (!f.boolean(has_value))
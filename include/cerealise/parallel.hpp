@@ -0,0 +1,211 @@
+#pragma once
+#include "cerealise.hpp"
+#include "many.hpp"
+#include "vector.hpp"
+#include <vector>
+
+namespace cerealise {
+namespace detail {
+
+/// fixed-size elements are handled on one thread below this many bytes
+inline constexpr size_t parallel_min_bytes = 1 << 20;
+
+/// variable-size elements are handled on one thread below this many values
+inline constexpr size_t parallel_min_values = 1 << 14;
+
+/// buffers which parallel_vector can split between threads: memory, or a
+/// sink which can provide one window for the whole vector
+template <typename F>
+concept SplitUnparseBuf = requires(F &f, uint8_t *&p, size_t n) {
+  typename F::format;
+  { f.window(p, n) } -> std::convertible_to<bool>;
+};
+
+template <typename F>
+concept SplitParseBuf = requires(F &f, const uint8_t *&p, size_t &n) {
+  typename F::format;
+  { f.view(p, n) } -> std::convertible_to<bool>;
+  f.peek(p, n);
+  { f.options() } -> std::convertible_to<ParseOptions>;
+  f.memory_resource();
+};
+
+template <typename T, typename F, typename E>
+bool parallel_unparse(const T *x, size_t n, F &f, E &executor) {
+  using Format = typename F::format;
+  size_t n_runs = many_runs(n, executor);
+
+  // the size of each run, then its position relative to the first
+  std::vector<size_t> run_start(n_runs + 1, 0);
+  if constexpr (FixedSize<T>) {
+    size_t per_run = (n + n_runs - 1) / n_runs;
+    for (size_t run = 0; run <= n_runs; run++)
+      run_start[run] = std::min(n, run * per_run) * fixed_size_info<T>().size;
+  } else {
+    std::vector<uint8_t> run_ok(n_runs, 1);
+    parallel_runs(
+        executor, n, n_runs, [&](size_t run, size_t begin, size_t end) {
+          MeasureBuf mb;
+          run_ok[run] = adapt_range(x + begin, end - begin, mb);
+          run_start[run] = mb.bytes_written();
+        });
+    if (!all_runs_ok(run_ok))
+      return false;
+    std::exclusive_scan(run_start.begin(), run_start.end(), run_start.begin(),
+                        (size_t)0);
+  }
+
+  // fall back to unparsing serially if the sink can not provide one window
+  // for the whole vector
+  uint8_t *p;
+  if (!f.window(p, run_start[n_runs]))
+    return adapt_range(x, n, f);
+
+  std::vector<uint8_t> run_ok(n_runs, 1);
+  parallel_runs(executor, n, n_runs, [&](size_t run, size_t begin, size_t end) {
+    size_t run_len = run_start[run + 1] - run_start[run];
+    UnparseBuf<true, void, Format> ub(p + run_start[run], run_len);
+    run_ok[run] = adapt_range(x + begin, end - begin, ub) &&
+                  ub.bytes_written() == run_len;
+  });
+  return all_runs_ok(run_ok);
+}
+
+template <typename T, typename F, typename E>
+bool parallel_parse(T *x, size_t n, F &f, E &executor) {
+  using Format = typename F::format;
+  size_t n_runs = many_runs(n, executor);
+  size_t per_run = (n + n_runs - 1) / n_runs;
+
+  // the position of each run in the rest of the input
+  std::vector<size_t> run_start(n_runs + 1, 0);
+  if constexpr (FixedSize<T>) {
+    for (size_t run = 0; run <= n_runs; run++)
+      run_start[run] = std::min(n, run * per_run) * fixed_size_info<T>().size;
+  } else {
+    // variable-size values must be found one after another, but skipping
+    // is much cheaper than parsing
+    const uint8_t *rest;
+    size_t rest_len;
+    f.peek(rest, rest_len);
+
+    SkipBuf<Format> sb(rest, rest_len);
+    for (size_t run = 0; run < n_runs; run++) {
+      run_start[run] = sb.bytes_read();
+      size_t count = std::min(n, (run + 1) * per_run) - run * per_run;
+      if (!sb.template discard<T>(count))
+        return false;
+    }
+    run_start[n_runs] = sb.bytes_read();
+  }
+
+  const uint8_t *p;
+  if (!f.view(p, run_start[n_runs]))
+    return false;
+
+  // each run gets a slice of the remaining allocation budget in proportion
+  // to its number of values, and records how much of it was used
+  ParseOptions options = f.options();
+  size_t per_value = options.alloc_budget / n;
+  std::vector<size_t> run_used(n_runs, 0);
+
+  auto parse_run = [&](size_t run, size_t begin, size_t end, size_t budget) {
+    size_t run_len = run_start[run + 1] - run_start[run];
+    ParseOptions run_options = options;
+    run_options.alloc_budget = budget;
+    ParseBuf<true, void, Format> pb(p + run_start[run], run_len, run_options);
+    if (!adapt_range(x + begin, end - begin, pb) || pb.bytes_read() != run_len)
+      return false;
+    run_used[run] = budget - pb.options().alloc_budget;
+    return true;
+  };
+
+  std::vector<uint8_t> run_ok(n_runs, 1);
+  parallel_runs(executor, n, n_runs, [&](size_t run, size_t begin, size_t end) {
+    run_ok[run] = parse_run(run, begin, end, per_value * (end - begin));
+  });
+
+  // runs which failed may have needed more than their slice, so try them
+  // again one at a time with whatever the others did not use
+  size_t used = 0;
+  for (size_t run = 0; run < n_runs; run++)
+    used += run_used[run];
+  for (size_t run = 0; run < n_runs; run++) {
+    if (run_ok[run])
+      continue;
+    size_t begin = std::min(n, run * per_run);
+    size_t end = std::min(n, (run + 1) * per_run);
+    if (!parse_run(run, begin, end, options.alloc_budget - used))
+      return false;
+    used += run_used[run];
+  }
+
+  // charge what was used to the whole parse
+  return f.template check_length<uint8_t>(used, 0);
+}
+
+} // namespace detail
+
+/// parse/unparse a large vector on executor (see many.hpp); call this from an
+/// adapter in place of f(v)
+///
+/// the format is the same as for f(v). Runs of values are handled as separate
+/// tasks when parsing from or unparsing to memory (or a sink which can
+/// provide enough contiguous space, like the std::vector<uint8_t> overload of
+/// unparse), and the vector is big enough to be worth it; otherwise this is
+/// the same as f(v).
+///
+/// when unparsing values of variable size they are measured in parallel
+/// first, and when parsing they are found with skip before being parsed in
+/// parallel. When parsing, each thread gets a share of the remaining
+/// allocation budget; a run of values which needs more than its share is
+/// parsed again afterwards with what the others left. If
+/// ParseOptions::resource is set the values are parsed on this thread, as
+/// memory resources are not generally thread-safe.
+template <typename F, typename V, Executor E>
+bool parallel_vector(F &f, V &v, E &executor) {
+  using T = typename std::remove_cv_t<V>::value_type;
+  constexpr bool splittable =
+      F::parsing ? detail::SplitParseBuf<F> : detail::SplitUnparseBuf<F>;
+  if constexpr (!splittable)
+    return f(v);
+  else {
+    size_t size = v.size();
+    if (!f.varint(size))
+      return false;
+
+    if constexpr (F::parsing) {
+      if (!check_length<T>(f, size))
+        return false;
+      detail::use_resource(v, f);
+      v.resize(size);
+    }
+
+    bool serial;
+    if constexpr (detail::FixedSize<T>)
+      serial = size * detail::fixed_size_info<T>().size <
+               detail::parallel_min_bytes;
+    else
+      serial = size < detail::parallel_min_values;
+    if constexpr (F::parsing)
+      if (f.memory_resource())
+        serial = true;
+    if (serial)
+      return detail::adapt_range(v.data(), size, f);
+
+    if constexpr (F::parsing)
+      return detail::parallel_parse(v.data(), size, f, executor);
+    else
+      return detail::parallel_unparse(v.data(), size, f, executor);
+  }
+}
+
+/// parallel_vector, using up to n_threads threads (0 for one per core) which
+/// are started for each call
+template <typename F, typename V>
+bool parallel_vector(F &f, V &v, unsigned n_threads = 0) {
+  ThreadExecutor executor(n_threads);
+  return parallel_vector(f, v, executor);
+}
+
+} // namespace cerealise
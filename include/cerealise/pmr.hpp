@@ -0,0 +1,37 @@
+#pragma once
+#include "cerealise.hpp"
+#include <memory>
+#include <memory_resource>
+
+namespace cerealise {
+namespace detail {
+
+template <typename R> struct ResourceCast {
+  static void *to_void(R *r) {
+    return static_cast<std::pmr::memory_resource *>(r);
+  }
+};
+
+/// when parsing with ParseOptions::resource set, replace the pmr container v
+/// with an empty one using that resource, if it does not already use it
+///
+/// elements created by the container then use the same resource if they
+/// support uses-allocator construction (like pmr containers), and other
+/// nested pmr containers are replaced when they are parsed. Containers with
+/// other allocators are left alone.
+template <typename V, typename F> void use_resource(V &v, F &f) {
+  using A = typename V::allocator_type;
+  if constexpr (std::is_same_v<
+                    A, std::pmr::polymorphic_allocator<typename A::value_type>>)
+    if constexpr (requires { f.memory_resource(); }) {
+      auto *resource =
+          static_cast<std::pmr::memory_resource *>(f.memory_resource().get());
+      if (resource && v.get_allocator().resource() != resource) {
+        std::destroy_at(&v);
+        std::construct_at(&v, resource);
+      }
+    }
+}
+
+} // namespace detail
+} // namespace cerealise
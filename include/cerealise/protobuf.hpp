@@ -0,0 +1,831 @@
+#pragma once
+#include "cerealise.hpp"
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace cerealise {
+
+/// serialise v into buf in protobuf wire format
+///
+/// field numbers are assigned in the order that the adapter for v (and for
+/// any nested types) uses the buffer, starting at 1; see the README for how
+/// types are mapped.
+///
+/// buf_len: length of buf, the maximum possible size
+/// bytes_written: the number of bytes written to buf
+///
+/// returns true if serialisation was successful (enough space, and no other
+/// errors)
+template <typename T>
+bool unparse_protobuf(const T &v, uint8_t *buf, size_t buf_len,
+                      size_t &bytes_written);
+
+/// parse a protobuf message from buf, writing into v
+///
+/// the whole of buf is parsed as one message. Fields which are not present
+/// are set to their default values, and unknown fields are ignored.
+///
+/// returns true if parsing was successful
+template <typename T> bool parse_protobuf(T &v, const uint8_t *buf, size_t len);
+
+/// get the number of bytes required to serialise v in protobuf wire format
+///
+/// returns 0 in case of error
+template <typename T> size_t measure_protobuf(const T &v);
+
+namespace detail {
+namespace protobuf {
+
+enum WireType : uint8_t {
+  VARINT = 0,
+  I64 = 1,
+  LEN = 2,
+  I32 = 5,
+};
+
+template <typename T> struct is_vector : std::false_type {};
+template <typename T> struct is_vector<std::vector<T>> : std::true_type {};
+
+template <typename T> struct is_array : std::false_type {};
+template <typename T, size_t N>
+struct is_array<std::array<T, N>> : std::true_type {};
+
+template <typename T> struct is_optional : std::false_type {};
+template <typename T> struct is_optional<std::optional<T>> : std::true_type {};
+
+template <typename T> struct is_variant : std::false_type {};
+template <typename... T>
+struct is_variant<std::variant<T...>> : std::true_type {};
+
+/// types encoded as a single LEN field containing raw bytes
+template <typename T>
+constexpr bool is_bytes =
+    std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view> ||
+    std::is_same_v<T, std::vector<uint8_t>> ||
+    std::is_same_v<T, std::span<const uint8_t>>;
+
+template <typename T>
+constexpr bool is_scalar = std::is_arithmetic_v<T>;
+
+template <typename T>
+constexpr bool is_repeated = (is_vector<T>::value || is_array<T>::value) &&
+                             !is_bytes<T>;
+
+/// types which can be used as a single value of a field (i.e. not repeated,
+/// optional or oneof)
+template <typename T>
+constexpr bool is_single = !is_repeated<T> && !is_optional<T>::value &&
+                           !is_variant<T>::value;
+
+/// wire type for integers of size bytes; 4 and 8-byte integers are fixed32 /
+/// fixed64 (or sfixed), others are uint32 / sint32 varints
+template <size_t size> constexpr WireType int_wire_type() {
+  return size == 4 ? I32 : size == 8 ? I64 : VARINT;
+}
+
+template <typename T> constexpr WireType scalar_wire_type() {
+  if constexpr (std::is_same_v<T, bool>)
+    return VARINT;
+  else if constexpr (std::is_integral_v<T>)
+    return int_wire_type<sizeof(T)>();
+  else {
+    static_assert(sizeof(T) == 4 || sizeof(T) == 8,
+                  "only float and double are supported");
+    return sizeof(T) == 4 ? I32 : I64;
+  }
+}
+
+/// get the varint used to encode integer x
+template <typename T> uint64_t to_varint(T x) {
+  if constexpr (std::is_signed_v<T>)
+    return (uint64_t)encode_zigzag(x);
+  else
+    return (uint64_t)x;
+}
+
+/// a field read from a message
+struct Field {
+  uint32_t number;
+  WireType wire_type;
+  uint64_t value; // for VARINT, I32 and I64
+  const uint8_t *data; // for LEN
+  size_t len;          // for LEN
+  size_t offset;       // position in the message
+};
+
+/// LEB128 varint, as used by protobuf
+inline bool read_varint(const uint8_t *&p, const uint8_t *end, uint64_t &x) {
+  x = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    if (p == end)
+      return false;
+    uint8_t b = *p++;
+    x |= (uint64_t)(b & 0x7f) << shift;
+    if (!(b & 0x80))
+      return true;
+  }
+  return false;
+}
+
+inline uint64_t read_le(const uint8_t *p, size_t size) {
+  uint64_t x = 0;
+  for (size_t i = 0; i < size; i++)
+    x |= (uint64_t)p[i] << (i * 8);
+  return x;
+}
+
+/// read the field at p, advancing p past it
+inline bool read_field(const uint8_t *&p, const uint8_t *end, Field &field) {
+  uint64_t tag;
+  if (!read_varint(p, end, tag))
+    return false;
+  field.number = (uint32_t)(tag >> 3);
+  field.wire_type = (WireType)(tag & 7);
+  if (field.number == 0)
+    return false;
+
+  switch (field.wire_type) {
+  case VARINT:
+    return read_varint(p, end, field.value);
+  case I64:
+  case I32: {
+    size_t size = field.wire_type == I64 ? 8 : 4;
+    if ((size_t)(end - p) < size)
+      return false;
+    field.value = read_le(p, size);
+    p += size;
+    return true;
+  }
+  case LEN: {
+    uint64_t len;
+    if (!read_varint(p, end, len) || len > (uint64_t)(end - p))
+      return false;
+    field.data = p;
+    field.len = len;
+    p += len;
+    return true;
+  }
+  default:
+    return false; // groups are not supported
+  }
+}
+
+/// the sizes of nested messages, which are written before their contents
+///
+/// the outermost nested message is measured once, recording its size and the
+/// sizes of any messages inside it in the order they are written, so that
+/// writing them does not measure them again
+struct SizeCache {
+  std::vector<size_t> sizes;
+  size_t next = 0;
+};
+
+/// buffer which writes (or, if measuring, counts) protobuf wire format
+template <bool measuring> class UnparseBuf {
+public:
+  static constexpr bool parsing = false;
+
+  /// cache: if not nullptr, the sizes of nested messages are recorded in it
+  UnparseBuf(SizeCache *cache = nullptr) requires(measuring) : cache(cache) {}
+
+  UnparseBuf(uint8_t *buf, size_t len, SizeCache &cache) requires(!measuring)
+      : buf(buf), len(len), cache(&cache) {}
+
+  bool byte(const uint8_t &x) { return varint_field(next_number(), x); }
+
+  bool boolean(const bool &x) { return varint_field(next_number(), x); }
+
+  bool bytes(const uint8_t *p, size_t n) {
+    return tag(next_number(), LEN) && put_varint(n) && put(p, n);
+  }
+
+  bool borrowed_bytes(const uint8_t *p, size_t n) { return bytes(p, n); }
+
+  template <size_t size_p = 0, typename T> bool fixedint(const T &x) {
+    constexpr size_t size = size_p == 0 ? sizeof(T) : size_p;
+    static_assert(size <= sizeof(T), "data size must be less than type size");
+    return int_field<size>(next_number(), x);
+  }
+
+  template <typename T> bool native(const T &x) {
+    return write_field(next_number(), x);
+  }
+
+  template <typename T> bool varint(const T &x) {
+    return varint_field(next_number(), x);
+  }
+
+  template <typename T> bool fixedints(const T *x, size_t n) {
+    return packed(next_number(), x, n);
+  }
+
+  template <typename T> bool natives(const T *x, size_t n) {
+    return packed(next_number(), x, n);
+  }
+
+  template <typename T> bool varints(const T *x, size_t n) {
+    return packed_varints(next_number(), x, n);
+  }
+
+  template <typename T> bool operator()(const T &x) {
+    using U = std::remove_cv_t<T>;
+    if constexpr (is_variant<U>::value) {
+      // one field number for each alternative, like a oneof
+      uint32_t first = number + 1;
+      number += std::variant_size_v<U>;
+      return std::visit(
+          [&](const auto &alternative) {
+            return write_field(first + (uint32_t)x.index(), alternative);
+          },
+          x);
+    } else
+      return write_field(next_number(), x);
+  }
+
+  size_t bytes_written() const { return pos; }
+
+private:
+  template <bool> friend class UnparseBuf;
+
+  uint32_t next_number() { return ++number; }
+
+  template <typename T> bool write_field(uint32_t number, const T &x) {
+    if constexpr (is_scalar<T>) {
+      if constexpr (std::is_same_v<T, bool>)
+        return varint_field(number, x);
+      else if constexpr (std::is_integral_v<T>)
+        return int_field<sizeof(T)>(number, x);
+      else
+        return tag(number, scalar_wire_type<T>()) && put_native(x);
+    } else if constexpr (is_bytes<T>)
+      return tag(number, LEN) && put_varint(x.size()) &&
+             put((const uint8_t *)x.data(), x.size());
+    else if constexpr (is_optional<T>::value)
+      return !x.has_value() || write_field(number, x.value());
+    else if constexpr (is_repeated<T>) {
+      using E = typename T::value_type;
+      if constexpr (is_scalar<E>)
+        return packed(number, x.data(), x.size());
+      else {
+        static_assert(is_single<E>,
+                      "repeated fields must contain single values");
+        for (auto &element : x)
+          if (!write_field(number, element))
+            return false;
+        return true;
+      }
+    } else {
+      static_assert(!is_variant<T>::value,
+                    "variants can only be used directly in messages");
+      // nested message
+      size_t size;
+      if (!(nested_size(x, size) && tag(number, LEN) && put_varint(size)))
+        return false;
+
+      if constexpr (measuring) {
+        pos += size;
+        return true;
+      } else {
+        if (size > len - pos)
+          return false;
+        UnparseBuf<false> nested(buf + pos, size, *cache);
+        if (!Adapter<T>::template adapt<const T, UnparseBuf<false>>(x,
+                                                                    nested))
+          return false;
+        pos += size;
+        return true;
+      }
+    }
+  }
+
+  /// get the size of nested message x, from the cache if writing
+  template <typename T> bool nested_size(const T &x, size_t &size) {
+    if constexpr (measuring) {
+      size_t slot = 0;
+      if (cache) {
+        slot = cache->sizes.size();
+        cache->sizes.push_back(0);
+      }
+
+      UnparseBuf<true> nested(cache);
+      if (!Adapter<T>::template adapt<const T, UnparseBuf<true>>(x, nested))
+        return false;
+      size = nested.bytes_written();
+
+      if (cache)
+        cache->sizes[slot] = size;
+      return true;
+    } else {
+      if (cache->next == cache->sizes.size()) {
+        // not inside a message which has been measured, so measure this one
+        cache->sizes.clear();
+        cache->next = 0;
+        UnparseBuf<true> measure(cache);
+        if (!measure.nested_size(x, size))
+          return false;
+      }
+      size = cache->sizes[cache->next++];
+      return true;
+    }
+  }
+
+  template <size_t size, typename T> bool int_field(uint32_t number, T x) {
+    constexpr WireType wire_type = int_wire_type<size>();
+    if constexpr (wire_type == VARINT)
+      return varint_field(number, x);
+    else
+      return tag(number, wire_type) && put_le<size>((uint64_t)x);
+  }
+
+  template <typename T> bool varint_field(uint32_t number, T x) {
+    return tag(number, VARINT) && put_varint(to_varint(x));
+  }
+
+  /// packed repeated scalars; empty fields are omitted
+  template <typename T> bool packed(uint32_t number, const T *x, size_t n) {
+    if constexpr (scalar_wire_type<T>() == VARINT)
+      return packed_varints(number, x, n);
+    else {
+      if (n == 0)
+        return true;
+      if (!(tag(number, LEN) && put_varint(n * sizeof(T))))
+        return false;
+      for (size_t i = 0; i < n; i++)
+        if (!put_native(x[i]))
+          return false;
+      return true;
+    }
+  }
+
+  template <typename T>
+  bool packed_varints(uint32_t number, const T *x, size_t n) {
+    if (n == 0)
+      return true;
+
+    size_t size = 0;
+    for (size_t i = 0; i < n; i++)
+      size += varint_length(to_varint(x[i]));
+
+    if (!(tag(number, LEN) && put_varint(size)))
+      return false;
+    for (size_t i = 0; i < n; i++)
+      if (!put_varint(to_varint(x[i])))
+        return false;
+    return true;
+  }
+
+  bool tag(uint32_t number, WireType wire_type) {
+    return put_varint(((uint64_t)number << 3) | wire_type);
+  }
+
+  bool put_varint(uint64_t x) {
+    uint8_t encoded[10];
+    size_t n = 0;
+    do {
+      encoded[n++] = (uint8_t)((x & 0x7f) | (x >= 0x80 ? 0x80 : 0));
+      x >>= 7;
+    } while (x);
+    return put(encoded, n);
+  }
+
+  template <size_t size> bool put_le(uint64_t x) {
+    uint8_t encoded[size];
+    for (size_t i = 0; i < size; i++)
+      encoded[i] = (uint8_t)(x >> (i * 8));
+    return put(encoded, size);
+  }
+
+  template <typename T> bool put_native(const T &x) {
+    std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t> bits;
+    std::memcpy(&bits, &x, sizeof(T));
+    return put_le<sizeof(T)>(bits);
+  }
+
+  bool put(const uint8_t *p, size_t n) {
+    if constexpr (!measuring) {
+      if (n > len - pos)
+        return false;
+      std::copy_n(p, n, buf + pos);
+    }
+    pos += n;
+    return true;
+  }
+
+  uint8_t *buf = nullptr;
+  size_t len = 0;
+  size_t pos = 0;
+  uint32_t number = 0;
+  SizeCache *cache;
+};
+
+/// buffer which reads one protobuf message
+///
+/// the message is split into fields by index(), which sorts them by number
+/// so that each read can find the fields with the next number without
+/// searching the whole message; fields can be in any order
+class ParseBuf {
+public:
+  static constexpr bool parsing = true;
+
+  ParseBuf(const uint8_t *buf, size_t len) : buf(buf), end(buf + len) {}
+
+  /// split the message into fields; returns false if it can not be
+  bool index() {
+    fields.clear();
+    for (const uint8_t *p = buf; p != end;) {
+      Field field;
+      size_t offset = p - buf;
+      if (!read_field(p, end, field))
+        return false;
+      field.offset = offset;
+      fields.push_back(field);
+    }
+
+    // messages written by unparse_protobuf are already in order, and a stable
+    // sort keeps repeated fields in the order they were written
+    if (!std::is_sorted(fields.begin(), fields.end(), by_number))
+      std::stable_sort(fields.begin(), fields.end(), by_number);
+    return true;
+  }
+
+  bool byte(uint8_t &x) { return read_single(next_number(), x); }
+
+  bool boolean(bool &x) { return read_single(next_number(), x); }
+
+  bool bytes(uint8_t *p, size_t n) {
+    const uint8_t *data;
+    if (!view(data, n))
+      return false;
+    if (data)
+      std::copy_n(data, n, p);
+    else
+      std::fill_n(p, n, 0);
+    return true;
+  }
+
+  /// as ParseBuf::view, but points p to nullptr if the field is not present
+  bool view(const uint8_t *&p, size_t n) {
+    Field field;
+    bool found;
+    if (!find_last(next_number(), field, found))
+      return false;
+
+    p = nullptr;
+    if (!found)
+      return true;
+    if (field.wire_type != LEN || field.len != n)
+      return false;
+    p = field.data;
+    return true;
+  }
+
+  template <size_t size_p = 0, typename T> bool fixedint(T &x) {
+    constexpr size_t size = size_p == 0 ? sizeof(T) : size_p;
+    static_assert(size <= sizeof(T), "data size must be less than type size");
+
+    Field field;
+    bool found;
+    if (!find_last(next_number(), field, found))
+      return false;
+    if (!found) {
+      x = 0;
+      return true;
+    }
+    return read_int<size>(field.wire_type, field.value, x);
+  }
+
+  template <typename T> bool native(T &x) {
+    return read_single(next_number(), x);
+  }
+
+  template <typename T> bool varint(T &x) {
+    Field field;
+    bool found;
+    if (!find_last(next_number(), field, found))
+      return false;
+    if (!found) {
+      x = 0;
+      return true;
+    }
+    return read_int<0>(field.wire_type, field.value, x);
+  }
+
+  template <typename T> bool fixedints(T *x, size_t n) {
+    return read_packed(next_number(), x, n);
+  }
+
+  template <typename T> bool natives(T *x, size_t n) {
+    return read_packed(next_number(), x, n);
+  }
+
+  template <typename T> bool varints(T *x, size_t n) {
+    size_t count = 0;
+    bool ok = for_each(next_number(), [&](const Field &field) {
+      if (field.wire_type != LEN)
+        return count < n && read_int<0>(field.wire_type, field.value,
+                                        x[count++]);
+
+      const uint8_t *p = field.data, *field_end = field.data + field.len;
+      while (p != field_end) {
+        uint64_t value;
+        if (count == n || !read_varint(p, field_end, value) ||
+            !read_int<0>(VARINT, value, x[count++]))
+          return false;
+      }
+      return true;
+    });
+    if (!ok)
+      return false;
+
+    if (count == 0)
+      std::fill_n(x, n, T{});
+    return count == 0 || count == n;
+  }
+
+  template <typename T> bool operator()(T &x) {
+    using U = std::remove_cv_t<T>;
+    if constexpr (is_variant<U>::value) {
+      uint32_t first = number + 1;
+      number += std::variant_size_v<U>;
+
+      // the last alternative present in the message wins, as for a oneof
+      Field last;
+      bool found = false;
+      for (auto it = lower_bound(first);
+           it != fields.end() && it->number - first < std::variant_size_v<U>;
+           ++it)
+        if (!found || it->offset > last.offset) {
+          last = *it;
+          found = true;
+        }
+
+      if (!found) {
+        x = U{};
+        return true;
+      }
+      return read_alternative<0>(last.number - first, last, x);
+    } else
+      return read_field_number(next_number(), x);
+  }
+
+  size_t bytes_read() const { return end - buf; }
+
+private:
+  uint32_t next_number() { return ++number; }
+
+  static bool by_number(const Field &a, const Field &b) {
+    return a.number < b.number;
+  }
+
+  /// the first field with a number of at least number
+  std::vector<Field>::const_iterator lower_bound(uint32_t number) const {
+    return std::lower_bound(
+        fields.begin(), fields.end(), number,
+        [](const Field &field, uint32_t n) { return field.number < n; });
+  }
+
+  /// call fn for each field with the given number, in order
+  template <typename Fn> bool for_each(uint32_t number, Fn fn) const {
+    for (auto it = lower_bound(number);
+         it != fields.end() && it->number == number; ++it)
+      if (!fn(*it))
+        return false;
+    return true;
+  }
+
+  /// find the last field with the given number
+  bool find_last(uint32_t number, Field &last, bool &found) const {
+    found = false;
+    return for_each(number, [&](const Field &field) {
+      last = field;
+      found = true;
+      return true;
+    });
+  }
+
+  template <typename T> bool read_single(uint32_t number, T &x) {
+    Field field;
+    bool found;
+    if (!find_last(number, field, found))
+      return false;
+    if (!found) {
+      x = T{};
+      return true;
+    }
+    return read_value(field, x);
+  }
+
+  template <typename T> bool read_field_number(uint32_t number, T &x) {
+    if constexpr (is_optional<T>::value) {
+      Field field;
+      bool found;
+      if (!find_last(number, field, found))
+        return false;
+      if (!found) {
+        x.reset();
+        return true;
+      }
+      x.emplace();
+      return read_value(field, x.value());
+    } else if constexpr (is_vector<T>::value && !is_bytes<T>) {
+      using E = typename T::value_type;
+      x.clear();
+      return for_each(number, [&](const Field &field) {
+        if constexpr (is_scalar<E>) {
+          if (field.wire_type == LEN)
+            return read_packed_field<E>(field, [&](const E &e) {
+              x.push_back(e);
+              return true;
+            });
+        }
+        x.emplace_back();
+        return read_value(field, x.back());
+      });
+    } else if constexpr (is_array<T>::value) {
+      using E = typename T::value_type;
+      size_t count = 0;
+      bool ok = for_each(number, [&](const Field &field) {
+        if constexpr (is_scalar<E>) {
+          if (field.wire_type == LEN)
+            return read_packed_field<E>(field, [&](const E &e) {
+              if (count == x.size())
+                return false;
+              x[count++] = e;
+              return true;
+            });
+        }
+        return count < x.size() && read_value(field, x[count++]);
+      });
+      if (!ok)
+        return false;
+      if (count == 0)
+        x = T{};
+      return count == 0 || count == x.size();
+    } else
+      return read_single(number, x);
+  }
+
+  template <size_t I, typename V>
+  bool read_alternative(size_t index, const Field &field, V &x) {
+    if constexpr (I < std::variant_size_v<V>) {
+      if (index == I)
+        return read_value(field, x.template emplace<I>());
+      return read_alternative<I + 1>(index, field, x);
+    } else
+      return false;
+  }
+
+  /// read one value from a field
+  template <typename T> bool read_value(const Field &field, T &x) {
+    static_assert(is_single<T>, "repeated fields must contain single values");
+
+    if constexpr (std::is_same_v<T, bool>) {
+      if (field.wire_type != VARINT)
+        return false;
+      x = field.value != 0;
+      return true;
+    } else if constexpr (std::is_integral_v<T>)
+      return read_int<sizeof(T)>(field.wire_type, field.value, x);
+    else if constexpr (std::is_floating_point_v<T>) {
+      if (field.wire_type != scalar_wire_type<T>())
+        return false;
+      std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t> bits =
+          field.value;
+      std::memcpy(&x, &bits, sizeof(T));
+      return true;
+    } else if constexpr (is_bytes<T>) {
+      if (field.wire_type != LEN)
+        return false;
+      if constexpr (std::is_same_v<T, std::string_view>)
+        x = T((const char *)field.data, field.len);
+      else if constexpr (std::is_same_v<T, std::span<const uint8_t>>)
+        x = T(field.data, field.len);
+      else
+        x.assign((const typename T::value_type *)field.data,
+                 (const typename T::value_type *)field.data + field.len);
+      return true;
+    } else {
+      // nested message
+      if (field.wire_type != LEN)
+        return false;
+      ParseBuf nested(field.data, field.len);
+      return nested.index() &&
+             Adapter<T>::template adapt<T, ParseBuf>(x, nested);
+    }
+  }
+
+  /// read an integer which was encoded with int_field<size>; size 0 is for
+  /// varints
+  template <size_t size, typename T>
+  static bool read_int(WireType wire_type, uint64_t value, T &x) {
+    constexpr WireType expected = size == 0 ? VARINT : int_wire_type<size>();
+    if (wire_type != expected)
+      return false;
+
+    using U = std::make_unsigned_t<T>;
+    if constexpr (expected == VARINT) {
+      if constexpr (sizeof(T) < 8)
+        if (value >> (sizeof(T) * 8))
+          return false;
+      if constexpr (std::is_signed_v<T>)
+        x = decode_zigzag((U)value);
+      else
+        x = (T)value;
+    } else {
+      // sign extend if necessary
+      x = (T)(U)value;
+      if constexpr (std::is_signed_v<T> && size < sizeof(T)) {
+        T signbit = (T)1 << (size * 8 - 1);
+        x = (x ^ signbit) - signbit;
+      }
+    }
+    return true;
+  }
+
+  /// call fn with each value in a packed field
+  template <typename T, typename Fn>
+  bool read_packed_field(const Field &field, Fn fn) {
+    const uint8_t *p = field.data, *field_end = field.data + field.len;
+    constexpr WireType wire_type = scalar_wire_type<T>();
+    while (p != field_end) {
+      Field value{field.number, wire_type, 0, nullptr, 0, field.offset};
+      if constexpr (wire_type == VARINT) {
+        if (!read_varint(p, field_end, value.value))
+          return false;
+      } else {
+        if ((size_t)(field_end - p) < sizeof(T))
+          return false;
+        value.value = read_le(p, sizeof(T));
+        p += sizeof(T);
+      }
+
+      T x;
+      if (!read_value(value, x) || !fn(x))
+        return false;
+    }
+    return true;
+  }
+
+  template <typename T> bool read_packed(uint32_t number, T *x, size_t n) {
+    size_t count = 0;
+    bool ok = for_each(number, [&](const Field &field) {
+      if (field.wire_type == LEN)
+        return read_packed_field<T>(field, [&](const T &e) {
+          if (count == n)
+            return false;
+          x[count++] = e;
+          return true;
+        });
+      return count < n && read_value(field, x[count++]);
+    });
+    if (!ok)
+      return false;
+
+    if (count == 0)
+      std::fill_n(x, n, T{});
+    return count == 0 || count == n;
+  }
+
+  const uint8_t *buf;
+  const uint8_t *end;
+  std::vector<Field> fields;
+  uint32_t number = 0;
+};
+
+} // namespace protobuf
+} // namespace detail
+
+template <typename T>
+bool unparse_protobuf(const T &v, uint8_t *buf, size_t buf_len,
+                      size_t &bytes_written) {
+  detail::protobuf::SizeCache cache;
+  detail::protobuf::UnparseBuf<false> pb(buf, buf_len, cache);
+
+  bool res = Adapter<T>::template adapt<const T>(v, pb);
+  bytes_written = pb.bytes_written();
+  return res;
+}
+
+template <typename T>
+bool parse_protobuf(T &v, const uint8_t *buf, size_t len) {
+  detail::protobuf::ParseBuf pb(buf, len);
+
+  return pb.index() && Adapter<T>::template adapt<T>(v, pb);
+}
+
+template <typename T> size_t measure_protobuf(const T &v) {
+  detail::protobuf::UnparseBuf<true> pb;
+
+  if (!Adapter<T>::template adapt<const T>(v, pb))
+    return 0;
+  else
+    return pb.bytes_written();
+}
+
+} // namespace cerealise
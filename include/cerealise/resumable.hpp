@@ -0,0 +1,162 @@
+#pragma once
+#include "cerealise.hpp"
+#include <memory>
+#include <ucontext.h>
+#include <vector>
+
+namespace cerealise {
+
+/// parser for a stream of values which arrives in pieces, for example from
+/// a non-blocking socket
+///
+/// input is passed to feed() as it arrives, and poll() parses as far as
+/// possible. When the input runs out part way through a value, the parser is
+/// suspended where it is and continued by the next call to poll(), so each
+/// byte is only parsed once however the input is split up.
+///
+/// the parse runs on a separate stack of stack_size bytes (using ucontext),
+/// which must be big enough for the nesting depth of T. Destroying a parser
+/// part way through a value does not destroy local variables of adapters
+/// which are in progress; the built-in adapters have none which own memory.
+///
+/// as with parse(), values are parsed into the existing value(), which is not
+/// cleared between values.
+template <typename T, FormatPolicy Format = BigEndian> class ResumableParser {
+public:
+  ResumableParser(const ParseOptions &options = {},
+                  size_t stack_size = 64 * 1024)
+      : options(options), stack_size(stack_size), input{this} {}
+
+  ResumableParser(const ResumableParser &) = delete;
+  ResumableParser &operator=(const ResumableParser &) = delete;
+
+  /// add n bytes from p to the end of the input
+  void feed(const uint8_t *p, size_t n) {
+    // drop used data once it makes up most of the buffer, so that the cost
+    // of moving the rest is amortised
+    if (start == data.size()) {
+      data.clear();
+      start = 0;
+    } else if (start > data.size() / 2) {
+      data.erase(data.begin(), data.begin() + start);
+      start = 0;
+    }
+    data.insert(data.end(), p, p + n);
+  }
+
+  /// mark the end of the input, so that a partial value is an error
+  void finish_input() { input_finished = true; }
+
+  /// parse as much of the input as possible
+  ///
+  /// complete is set to true if a value has been parsed into value();
+  /// otherwise more input is needed. Call poll() again after handling a
+  /// complete value, as the input may contain more values.
+  ///
+  /// returns false if the input is invalid, or ends (see finish_input) part
+  /// way through a value; the parser can not be used after that
+  bool poll(bool &complete) {
+    complete = false;
+    if (state == State::failed)
+      return false;
+
+    if (state == State::idle) {
+      // only start a value once some of it has arrived
+      if (start == data.size())
+        return true;
+      start_fiber();
+    }
+
+    state = State::running;
+    swapcontext(&caller_context, &fiber_context);
+
+    if (state == State::complete) {
+      state = State::idle;
+      complete = true;
+    }
+    return state != State::failed;
+  }
+
+  /// the value parsed by the last call to poll which completed a value
+  T &value() { return v; }
+
+  /// the number of bytes in the last complete value
+  size_t bytes_read() const { return read; }
+
+private:
+  enum class State { idle, running, waiting, complete, failed };
+
+  /// Source for the parse running on the fiber, which suspends it until
+  /// enough input has arrived
+  struct Input {
+    ResumableParser *parser;
+
+    bool next(const uint8_t *&buf, size_t &len, size_t consumed, size_t n) {
+      return parser->next(buf, len, consumed, n);
+    }
+
+    void finish(size_t consumed) { parser->start += consumed; }
+  };
+
+  bool next(const uint8_t *&buf, size_t &len, size_t consumed, size_t n) {
+    start += consumed;
+
+    while (n > data.size() - start && !input_finished) {
+      state = State::waiting;
+      swapcontext(&fiber_context, &caller_context);
+    }
+
+    // feed may have moved the data while the fiber was suspended
+    buf = data.data() + start;
+    len = data.size() - start;
+    return true;
+  }
+
+  void start_fiber() {
+    if (!stack)
+      stack = std::make_unique<uint8_t[]>(stack_size);
+
+    getcontext(&fiber_context);
+    fiber_context.uc_stack.ss_sp = stack.get();
+    fiber_context.uc_stack.ss_size = stack_size;
+    // when run returns, continue from the last call to poll
+    fiber_context.uc_link = &caller_context;
+
+    // makecontext only passes int arguments, so split this into two
+    uint64_t self = (uint64_t)(uintptr_t)this;
+    makecontext(&fiber_context, (void (*)())&entry, 2, (unsigned)self,
+                (unsigned)(self >> 32));
+  }
+
+  static void entry(unsigned low, unsigned high) {
+    uint64_t self = ((uint64_t)high << 32) | low;
+    ((ResumableParser *)(uintptr_t)self)->run();
+  }
+
+  void run() {
+    detail::ParseBuf<true, Input, Format> pb(input, options);
+
+    bool res = pb(v);
+    pb.finish();
+    read = pb.bytes_read();
+    state = res ? State::complete : State::failed;
+  }
+
+  T v{};
+  ParseOptions options;
+  size_t stack_size;
+  Input input;
+
+  std::vector<uint8_t> data;
+  size_t start = 0;
+  bool input_finished = false;
+
+  State state = State::idle;
+  size_t read = 0;
+
+  std::unique_ptr<uint8_t[]> stack;
+  ucontext_t caller_context;
+  ucontext_t fiber_context;
+};
+
+} // namespace cerealise
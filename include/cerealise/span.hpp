@@ -0,0 +1,29 @@
+#pragma once
+#include "cerealise.hpp"
+#include <span>
+
+namespace cerealise {
+
+/// std::span<const uint8_t>, with the same format as std::vector<uint8_t>
+///
+/// when parsing, the span points into the buffer passed to parse, so that
+/// must outlive the parsed value. Parsing from a Source is not supported.
+template <> struct Adapter<std::span<const uint8_t>> {
+  template <typename TT, typename F>
+  static constexpr bool adapt(TT &v, F &f) {
+    size_t size = v.size();
+    if (!f.varint(size))
+      return false;
+
+    if constexpr (F::parsing) {
+      const uint8_t *p;
+      if (!f.view(p, size))
+        return false;
+      v = std::span<const uint8_t>(p, size);
+      return true;
+    } else
+      return f.borrowed_bytes(v.data(), size);
+  }
+};
+
+} // namespace cerealise
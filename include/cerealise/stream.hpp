@@ -0,0 +1,185 @@
+#pragma once
+#include "cerealise.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <unistd.h>
+
+namespace cerealise {
+
+/// Sink which collects data in a fixed-size buffer, and passes it to write
+/// when it is full
+///
+/// Write is a callable like bool(const uint8_t *p, size_t n), which should
+/// write all n bytes from p, returning false on error.
+///
+/// data is kept in the buffer between calls to unparse; call flush() to write
+/// it out. Each fixed-width field must fit in the buffer, so it should be at
+/// least 16 bytes; fixed-size structures larger than the buffer are written
+/// field by field.
+template <typename Write> class BufferedSink {
+public:
+  BufferedSink(uint8_t *buf, size_t len, Write write)
+      : buf(buf), len(len), write(write) {}
+
+  bool next(uint8_t *&window, size_t &window_len, size_t written, size_t n) {
+    used += written;
+
+    if (n > len - used && !flush())
+      return false;
+
+    window = buf + used;
+    window_len = len - used;
+    return true;
+  }
+
+  bool finish(uint8_t *, size_t written) {
+    used += written;
+    return true;
+  }
+
+  /// write out any buffered data
+  bool flush() {
+    if (used > 0 && !write(buf, used))
+      return false;
+    used = 0;
+    return true;
+  }
+
+private:
+  uint8_t *buf;
+  size_t len;
+  size_t used = 0;
+  Write write;
+};
+
+/// Source which reads data into a fixed-size buffer using read
+///
+/// Read is a callable like bool(uint8_t *p, size_t n, size_t &bytes_read),
+/// which should read at least one and at most n bytes into p, setting
+/// bytes_read to 0 at the end of the input, and returning false on error.
+///
+/// data which has been read but not used by one call to parse is kept for the
+/// next. As with BufferedSink, the buffer should be at least 16 bytes.
+template <typename Read> class BufferedSource {
+public:
+  BufferedSource(uint8_t *buf, size_t len, Read read)
+      : buf(buf), len(len), read(read) {}
+
+  bool next(const uint8_t *&window, size_t &window_len, size_t consumed,
+            size_t n) {
+    start += consumed;
+
+    if (n > end - start) {
+      // move the unused data to the start to make space
+      std::copy(buf + start, buf + end, buf);
+      end -= start;
+      start = 0;
+
+      while (n > end - start && end < len) {
+        size_t bytes_read;
+        if (!read(buf + end, len - end, bytes_read))
+          return false;
+        if (bytes_read == 0)
+          break;
+        end += bytes_read;
+      }
+    }
+
+    window = buf + start;
+    window_len = end - start;
+    return true;
+  }
+
+  void finish(size_t consumed) { start += consumed; }
+
+private:
+  uint8_t *buf;
+  size_t len;
+  size_t start = 0;
+  size_t end = 0;
+  Read read;
+};
+
+namespace detail {
+struct FdWrite {
+  int fd;
+
+  bool operator()(const uint8_t *p, size_t n) {
+    while (n > 0) {
+      ssize_t res = ::write(fd, p, n);
+      if (res < 0) {
+        if (errno == EINTR)
+          continue;
+        return false;
+      }
+      p += res;
+      n -= res;
+    }
+    return true;
+  }
+};
+
+struct FdRead {
+  int fd;
+
+  bool operator()(uint8_t *p, size_t n, size_t &bytes_read) {
+    while (true) {
+      ssize_t res = ::read(fd, p, n);
+      if (res < 0) {
+        if (errno == EINTR)
+          continue;
+        return false;
+      }
+      bytes_read = res;
+      return true;
+    }
+  }
+};
+
+struct FileWrite {
+  FILE *file;
+
+  bool operator()(const uint8_t *p, size_t n) {
+    return fwrite(p, 1, n, file) == n;
+  }
+};
+
+struct FileRead {
+  FILE *file;
+
+  bool operator()(uint8_t *p, size_t n, size_t &bytes_read) {
+    bytes_read = fread(p, 1, n, file);
+    return !ferror(file);
+  }
+};
+} // namespace detail
+
+/// Sink which writes to a POSIX file descriptor, buffered in buf
+class FdSink : public BufferedSink<detail::FdWrite> {
+public:
+  FdSink(int fd, uint8_t *buf, size_t len)
+      : BufferedSink(buf, len, detail::FdWrite{fd}) {}
+};
+
+/// Source which reads from a POSIX file descriptor, buffered in buf
+class FdSource : public BufferedSource<detail::FdRead> {
+public:
+  FdSource(int fd, uint8_t *buf, size_t len)
+      : BufferedSource(buf, len, detail::FdRead{fd}) {}
+};
+
+/// Sink which writes to a FILE, buffered in buf
+class FileSink : public BufferedSink<detail::FileWrite> {
+public:
+  FileSink(FILE *file, uint8_t *buf, size_t len)
+      : BufferedSink(buf, len, detail::FileWrite{file}) {}
+};
+
+/// Source which reads from a FILE, buffered in buf
+class FileSource : public BufferedSource<detail::FileRead> {
+public:
+  FileSource(FILE *file, uint8_t *buf, size_t len)
+      : BufferedSource(buf, len, detail::FileRead{file}) {}
+};
+
+} // namespace cerealise
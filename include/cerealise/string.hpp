@@ -1,23 +1,30 @@
 #pragma once
 #include "cerealise.hpp"
+#include "pmr.hpp"
 #include <string>
 
 namespace cerealise {
 
-template <> struct Adapter<std::string> {
-  template <typename TT, typename F> static bool adapt(TT &v, F &f) {
+/// std::string with any allocator; when parsing into a std::pmr::string, see
+/// ParseOptions::resource
+template <typename Traits, typename A>
+struct Adapter<std::basic_string<char, Traits, A>> {
+  template <typename TT, typename F>
+  static constexpr bool adapt(TT &v, F &f) {
     size_t size = v.size();
     if (!f.varint(size))
       return false;
 
-    if constexpr (F::parsing)
-      v.resize(size);
-
-    for (size_t i = 0; i < size; i++)
-      if (!f(v[i]))
+    if constexpr (Discarding<F>)
+      return f.template discard<char>(size);
+    else if constexpr (F::parsing) {
+      if (!check_length<char>(f, size))
         return false;
-
-    return true;
+      detail::use_resource(v, f);
+      v.resize(size);
+      return f.bytes((uint8_t *)v.data(), size);
+    } else
+      return f.borrowed_bytes((const uint8_t *)v.data(), size);
   }
 };
 
@@ -0,0 +1,29 @@
+#pragma once
+#include "cerealise.hpp"
+#include <string_view>
+
+namespace cerealise {
+
+/// std::string_view, with the same format as std::string
+///
+/// when parsing, the view points into the buffer passed to parse, so that
+/// must outlive the parsed value. Parsing from a Source is not supported.
+template <> struct Adapter<std::string_view> {
+  template <typename TT, typename F>
+  static constexpr bool adapt(TT &v, F &f) {
+    size_t size = v.size();
+    if (!f.varint(size))
+      return false;
+
+    if constexpr (F::parsing) {
+      const uint8_t *p;
+      if (!f.view(p, size))
+        return false;
+      v = std::string_view((const char *)p, size);
+      return true;
+    } else
+      return f.borrowed_bytes((const uint8_t *)v.data(), size);
+  }
+};
+
+} // namespace cerealise
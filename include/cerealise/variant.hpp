@@ -1,51 +1,46 @@
 #pragma once
 
 #include "cerealise.hpp"
+#include <utility>
 #include <variant>
 
 namespace cerealise {
 namespace detail {
-template <typename TT, typename F, typename T> bool parse_variant(TT &v, F &f) {
-  T v_value;
-  if (f(v_value)) {
-    v = v_value;
-    return true;
-  } else
-    return false;
+/// parse alternative t_idx directly into v, reusing the current value if it
+/// already holds that alternative
+template <size_t t_idx, typename TT, typename F>
+constexpr bool parse_variant(TT &v, F &f) {
+  if (v.index() == t_idx)
+    return f(std::get<t_idx>(v));
+  else
+    return f(v.template emplace<t_idx>());
 }
 
-template <size_t t_idx, typename T, typename... Rest>
-struct VariantParseHelper {
-  template <typename TT, typename F>
-  static bool run(size_t this_idx, TT &v, F &f) {
-    if (this_idx == t_idx)
-      return parse_variant<TT, F, T>(v, f);
-    else
-      return VariantParseHelper<t_idx + 1, Rest...>::template run<TT, F>(
-          this_idx, v, f);
-  }
-};
+/// parse alternative this_idx into v, using a table indexed by this_idx
+/// rather than comparing against each index in turn
+template <typename TT, typename F, size_t... t_idx>
+constexpr bool parse_variant_index(size_t this_idx, TT &v, F &f,
+                                   std::index_sequence<t_idx...>) {
+  using Parser = bool (*)(TT &, F &);
+  constexpr Parser parsers[] = {&parse_variant<t_idx, TT, F>...};
 
-template <size_t t_idx, typename T> struct VariantParseHelper<t_idx, T> {
-  template <typename TT, typename F>
-  static bool run(size_t this_idx, TT &v, F &f) {
-    if (this_idx != t_idx)
-      return false;
-    return parse_variant<TT, F, T>(v, f);
-  }
-};
+  if (this_idx >= sizeof...(t_idx))
+    return false;
+  return parsers[this_idx](v, f);
+}
 } // namespace detail
 
 template <typename... T> struct Adapter<std::variant<T...>> {
-  template <typename TT, typename F> static bool adapt(TT &v, F &f) {
+  template <typename TT, typename F>
+  static constexpr bool adapt(TT &v, F &f) {
     if constexpr (F::parsing) {
       size_t idx;
       return f.varint(idx) &&
-             detail::VariantParseHelper<0, T...>::template run<TT, F>(idx, v,
-                                                                      f);
+             detail::parse_variant_index(idx, v, f,
+                                         std::index_sequence_for<T...>{});
     } else
       return f.varint(v.index()) &&
-             std::visit([&f](auto vv) -> bool { return f(vv); }, v);
+             std::visit([&f](const auto &vv) -> bool { return f(vv); }, v);
   }
 };
 } // namespace cerealise
@@ -1,11 +1,16 @@
 #pragma once
 #include "cerealise.hpp"
+#include "pmr.hpp"
+#include <algorithm>
 #include <vector>
 
 namespace cerealise {
 
-template <typename T> struct Adapter<std::vector<T>> {
-  template <typename TT, typename F> static bool adapt(TT &v, F &f) {
+/// std::vector with any allocator; when parsing into a std::pmr::vector, see
+/// ParseOptions::resource
+template <typename T, typename A> struct Adapter<std::vector<T, A>> {
+  template <typename TT, typename F>
+  static constexpr bool adapt(TT &v, F &f) {
     size_t size;
     if constexpr (!F::parsing)
       size = v.size();
@@ -13,15 +18,102 @@ template <typename T> struct Adapter<std::vector<T>> {
     if (!f.varint(size))
       return false;
 
-    if constexpr (F::parsing)
+    if constexpr (Discarding<F>)
+      return f.template discard<T>(size);
+
+    if constexpr (F::parsing) {
+      if (!check_length<T>(f, size))
+        return false;
+      detail::use_resource(v, f);
       v.resize(size);
+    } else if constexpr (std::is_same_v<T, uint8_t>)
+      return f.borrowed_bytes(v.data(), size);
+
+    return detail::adapt_range(v.data(), size, f);
+  }
+};
+
+/// parse/unparse a std::vector of integers as a varint count followed by a
+/// varint for each value; call this from an adapter in place of f(v) for
+/// vectors of mostly small values
+template <typename F, typename V> bool varint_vector(F &f, V &v) {
+  using T = typename std::remove_cv_t<V>::value_type;
+  static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>,
+                "varint_vector requires a vector of integers");
 
-    for (auto &element : v)
-      if (!f(element))
+  size_t size = v.size();
+  if (!f.varint(size))
+    return false;
+
+  // each value takes at least one byte
+  if (!check_length<T>(f, size, size))
+    return false;
+
+  if constexpr (Discarding<F>) {
+    // values must still be read to find their length
+    T values[64];
+    for (size_t start = 0; start < size; start += std::size(values))
+      if (!f.varints(values, std::min(size - start, std::size(values))))
         return false;
+    return true;
+  } else {
+    if constexpr (F::parsing) {
+      detail::use_resource(v, f);
+      v.resize(size);
+    }
+    return f.varints(v.data(), size);
+  }
+}
 
+/// Sink which appends to a std::vector<uint8_t>
+///
+/// the window is grown geometrically with the amount written by this call
+/// (not the size of the whole vector, so that appending a small value to a
+/// large vector is cheap), and the vector is trimmed to the written size by
+/// finish, so its capacity can be reused between calls
+class VectorSink {
+public:
+  VectorSink(std::vector<uint8_t> &v) : v(v), start(v.size()), used(start) {}
+
+  bool next(uint8_t *&buf, size_t &len, size_t written, size_t n) {
+    used += written;
+
+    static constexpr size_t min_size = 64;
+    v.resize(used + std::max({n, used - start, min_size}));
+
+    buf = v.data() + used;
+    len = v.size() - used;
+    return true;
+  }
+
+  bool finish(uint8_t *, size_t written) {
+    used += written;
+    v.resize(used);
     return true;
   }
+
+private:
+  std::vector<uint8_t> &v;
+  size_t start;
+  size_t used;
 };
 
+/// serialise v, appending to buf
+///
+/// bytes_written: the number of bytes appended to buf
+///
+/// returns true if serialisation was successful; buf is not modified if
+/// serialisation fails
+template <FormatPolicy Format = BigEndian, typename T>
+bool unparse(const T &v, std::vector<uint8_t> &buf, size_t &bytes_written) {
+  size_t old_size = buf.size();
+  VectorSink sink(buf);
+
+  if (unparse<Format>(v, sink, bytes_written))
+    return true;
+
+  buf.resize(old_size);
+  return false;
+}
+
 } // namespace cerealise
@@ -1,8 +1,12 @@
+#include <algorithm>
 #include <compare>
 #include <limits>
+#include <span>
+#include <vector>
 
 #include "catch.hpp"
 #include "cerealise/cerealise.hpp"
+#include "cerealise/vector.hpp"
 #include "utils.hpp"
 
 template <typename T, size_t size = sizeof(T)> struct FixedIntTest {
@@ -79,3 +83,230 @@ TEST_CASE("zigzag") {
     REQUIRE(decode_zigzag(encode_zigzag(x)) == x);
   }
 }
+
+TEST_CASE("fixedint byte order") {
+  FixedIntTest<uint32_t> v{0x12345678};
+  uint8_t buf[4];
+  size_t len;
+  REQUIRE(cerealise::unparse(v, buf, sizeof(buf), len));
+  REQUIRE(len == 4);
+  REQUIRE(buf[0] == 0x12);
+  REQUIRE(buf[3] == 0x78);
+}
+
+struct FormatTest {
+  uint32_t a;
+  int32_t b; // 3 bytes
+  double c;
+  uint16_t d[3];
+
+  template <typename TT, typename F> static bool cerealise(TT &v, F &f) {
+    return f(v.a) && f.template fixedint<3>(v.b) && f(v.c) &&
+           f.fixedints(v.d, 3);
+  }
+
+  auto operator<=>(const FormatTest &) const = default;
+};
+
+template <typename Format>
+void check_format(const FormatTest &v, const std::vector<uint8_t> &expected) {
+  std::vector<uint8_t> buf(expected.size());
+  size_t len;
+  REQUIRE(cerealise::measure<Format>(v) == expected.size());
+  REQUIRE(cerealise::unparse<Format>(v, buf.data(), buf.size(), len));
+  REQUIRE(len == expected.size());
+  REQUIRE(buf == expected);
+
+  FormatTest v2;
+  REQUIRE(cerealise::parse<Format>(v2, buf.data(), buf.size(), len));
+  REQUIRE(len == expected.size());
+  REQUIRE(v2 == v);
+}
+
+TEST_CASE("format policies") {
+  FormatTest v{0x01020304, -2, 1.0, {0x0102, 0x0304, 0x0506}};
+
+  std::vector<uint8_t> big{1, 2, 3, 4, 0xff, 0xff, 0xfe,
+                           0, 0, 0, 0, 0, 0, 0xf0, 0x3f,
+                           1, 2, 3, 4, 5, 6};
+  std::vector<uint8_t> little{4, 3, 2, 1, 0xfe, 0xff, 0xff,
+                              0, 0, 0, 0, 0, 0, 0xf0, 0x3f,
+                              2, 1, 4, 3, 6, 5};
+
+  check_format<cerealise::BigEndian>(v, big);
+  check_format<cerealise::LittleEndian>(v, little);
+  if constexpr (std::endian::native == std::endian::little)
+    check_format<cerealise::HostEndian>(v, little);
+
+  // the default is big-endian
+  std::vector<uint8_t> buf(big.size());
+  size_t len;
+  REQUIRE(cerealise::unparse(v, buf.data(), buf.size(), len));
+  REQUIRE(buf == big);
+}
+
+TEST_CASE("short buffers") {
+  FixedIntTest<uint32_t> v{0x12345678};
+  uint8_t buf[4];
+  size_t len;
+  REQUIRE(!cerealise::unparse(v, buf, 3, len));
+  REQUIRE(cerealise::unparse(v, buf, 4, len));
+  REQUIRE(!cerealise::parse(v, buf, 3, len));
+}
+
+TEST_CASE("const buffers") {
+  FixedIntTest<uint32_t> v{0x12345678}, parsed{0};
+  uint8_t buf[4];
+  size_t len;
+  REQUIRE(cerealise::unparse(v, buf, sizeof(buf), len));
+
+  const uint8_t *const_buf = buf;
+  REQUIRE(cerealise::parse(parsed, const_buf, sizeof(buf), len));
+  REQUIRE(parsed == v);
+
+  parsed.x = 0;
+  std::span<const std::byte> span = std::as_bytes(std::span(buf));
+  REQUIRE(cerealise::parse(parsed, span, len));
+  REQUIRE(len == 4);
+  REQUIRE(parsed == v);
+  REQUIRE(!cerealise::parse(parsed, span.first(3), len));
+}
+
+template <typename T> struct VarIntsTest {
+  std::vector<T> x;
+
+  template <typename TT, typename F> static bool cerealise(TT &v, F &f) {
+    return cerealise::varint_vector(f, v.x);
+  }
+
+  bool operator==(const VarIntsTest<T> &) const = default;
+};
+
+template <typename T> void check_varints(const std::vector<T> &values) {
+  std::vector<VarIntTest<T>> element_wise;
+  for (T value : values)
+    element_wise.push_back({value});
+
+  std::vector<uint8_t> buf(values.size() * 10);
+  size_t expected_len = 0;
+  for (auto &value : element_wise) {
+    size_t value_len;
+    REQUIRE(cerealise::unparse(value, buf.data() + expected_len,
+                               buf.size() - expected_len, value_len));
+    expected_len += value_len;
+  }
+
+  VarIntsTest<T> parsed;
+  parsed.x.resize(values.size());
+  cerealise::detail::ParseBuf<> pb(buf.data(), expected_len);
+  REQUIRE(pb.varints(parsed.x.data(), parsed.x.size()));
+  REQUIRE(pb.bytes_read() == expected_len);
+  REQUIRE(parsed.x == values);
+
+  check_parse_unparse(VarIntsTest<T>{values});
+
+  std::vector<uint8_t> encoded;
+  size_t len;
+  REQUIRE(cerealise::unparse(VarIntsTest<T>{values}, encoded, len));
+  REQUIRE(cerealise::validate<VarIntsTest<T>>(encoded.data(), len, len));
+  REQUIRE(len == encoded.size());
+  REQUIRE(cerealise::skip<VarIntsTest<T>>(encoded.data(), len, len));
+  REQUIRE(len == encoded.size());
+  REQUIRE(!cerealise::validate<VarIntsTest<T>>(encoded.data(), len - 1, len));
+  REQUIRE(!cerealise::skip<VarIntsTest<T>>(encoded.data(), len - 1, len));
+}
+
+TEST_CASE("varints") {
+  // mix of 1, 2 and longer values in runs of different lengths
+  std::vector<uint32_t> u;
+  std::vector<int32_t> s;
+  for (uint32_t i = 0; i < 2000; i++) {
+    uint32_t x = (i / 20) % 4 == 0 ? i % 128 : (i / 20) % 4 == 1 ? i * 7 : i;
+    if (i % 97 == 0)
+      x = 0xffffffff - i;
+    u.push_back(x);
+    s.push_back((int32_t)(i % 2 ? -x : x) / 2);
+  }
+  check_varints(u);
+  check_varints(s);
+
+  std::vector<uint16_t> u16;
+  for (uint32_t i = 0; i < 0x10000; i += 7)
+    u16.push_back(i);
+  check_varints(u16);
+
+  // values too big for the type
+  std::vector<uint8_t> buf(16, 0xff);
+  buf.back() = 0x7f;
+  uint16_t x[8];
+  cerealise::detail::ParseBuf<> pb(buf.data(), buf.size());
+  REQUIRE(!pb.varints(x, 8));
+
+
+  // a count which does not fit in the input
+  uint8_t hostile[] = {0xff, 0xff, 0x7f, 1, 2, 3};
+  size_t len;
+  VarIntsTest<uint32_t> parsed;
+  REQUIRE(!cerealise::parse(parsed, hostile, sizeof(hostile), len));
+  REQUIRE(parsed.x.capacity() == 0);
+  using Hostile = VarIntsTest<uint32_t>;
+  REQUIRE(!cerealise::validate<Hostile>(hostile, sizeof(hostile), len));
+  REQUIRE(!cerealise::skip<Hostile>(hostile, sizeof(hostile), len));
+
+  // values too big for the type are rejected when validating or skipping
+  uint8_t too_big[] = {1, 0x84, 0x80, 0x00};
+  REQUIRE(!cerealise::validate<VarIntsTest<uint16_t>>(too_big, 4, len));
+  REQUIRE(!cerealise::skip<VarIntsTest<uint16_t>>(too_big, 4, len));
+  REQUIRE(cerealise::skip<VarIntsTest<uint32_t>>(too_big, 4, len));
+  REQUIRE(len == 4);
+}
+
+template <typename T> void check_varint_paths(const uint8_t *data, size_t n) {
+  // parsing with at least 8 bytes available uses a different path
+  uint8_t padded[24] = {};
+  std::copy_n(data, n, padded);
+
+  T slow = 0, fast = 0;
+  cerealise::detail::ParseBuf<> slow_pb(data, n);
+  cerealise::detail::ParseBuf<> fast_pb(padded, n + 16);
+  bool slow_ok = slow_pb.varint(slow);
+  bool fast_ok = fast_pb.varint(fast);
+
+  REQUIRE(slow_ok == fast_ok);
+  if (slow_ok) {
+    REQUIRE(slow == fast);
+    REQUIRE(slow_pb.bytes_read() == fast_pb.bytes_read());
+  }
+}
+
+TEST_CASE("varint fast path") {
+  uint32_t state = 1;
+  for (size_t i = 0; i < 20000; i++) {
+    uint8_t data[8];
+    size_t n = i % 8 + 1;
+    for (size_t j = 0; j < n; j++) {
+      state = state * 1664525 + 1013904223;
+      data[j] = ((uint8_t)(state >> 24) & 0x7f) | (j + 1 < n ? 0x80 : 0);
+    }
+    if (i % 3 == 0)
+      data[0] &= 0x81; // small leading group, so that more values fit
+
+    check_varint_paths<uint8_t>(data, n);
+    check_varint_paths<uint16_t>(data, n);
+    check_varint_paths<int32_t>(data, n);
+    check_varint_paths<uint64_t>(data, n);
+  }
+
+  for (int shift = 0; shift < 64; shift++) {
+    for (uint64_t x : {(uint64_t)1 << shift, ((uint64_t)1 << shift) - 1}) {
+      VarIntTest<uint64_t> v{x}, parsed{0};
+      uint8_t buf[32];
+      size_t len, read_len;
+      REQUIRE(cerealise::unparse(v, buf, sizeof(buf), len));
+      REQUIRE(len == cerealise::measure(v));
+      REQUIRE(cerealise::parse(parsed, buf, sizeof(buf), read_len));
+      REQUIRE(read_len == len);
+      REQUIRE(parsed == v);
+    }
+  }
+}
@@ -0,0 +1,134 @@
+#include <compare>
+#include <limits>
+#include <memory_resource>
+#include <vector>
+
+#include "catch.hpp"
+#include "cerealise/cerealise.hpp"
+#include "cerealise/delta.hpp"
+#include "cerealise/iovec.hpp"
+#include "cerealise/vector.hpp"
+#include "utils.hpp"
+
+template <typename T> struct DeltaTest {
+  std::vector<T> x;
+
+  template <typename TT, typename F> static bool cerealise(TT &v, F &f) {
+    return cerealise::delta_packed(f, v.x);
+  }
+
+  auto operator<=>(const DeltaTest<T> &) const = default;
+};
+
+TEST_CASE("delta packed") {
+  check_parse_unparse(DeltaTest<uint32_t>{}, 1);
+  check_parse_unparse(DeltaTest<uint32_t>{{5}}, 2);
+
+  // timestamps with small jitter
+  DeltaTest<uint64_t> timestamps;
+  for (uint64_t i = 0; i < 1000; i++)
+    timestamps.x.push_back(1600000000000 + i * 1000 + i % 7);
+  size_t len = cerealise::measure(timestamps);
+  check_parse_unparse(timestamps);
+  REQUIRE(len < cerealise::measure(timestamps.x) / 4);
+
+  // extremes
+  using limits64 = std::numeric_limits<int64_t>;
+  check_parse_unparse(DeltaTest<int64_t>{
+      {0, limits64::max(), limits64::min(), -1, 1, limits64::min()}});
+  using limits8 = std::numeric_limits<int8_t>;
+  check_parse_unparse(DeltaTest<int8_t>{{limits8::max(), limits8::min(), 0}});
+
+  DeltaTest<int32_t> random;
+  uint32_t state = 1;
+  for (size_t i = 0; i < 500; i++) {
+    state = state * 1664525 + 1013904223;
+    random.x.push_back((int32_t)state >> (i % 31));
+  }
+  check_parse_unparse(random);
+}
+
+TEST_CASE("delta packed empty") {
+  // parsing an empty vector replaces the existing contents
+  uint8_t buf[] = {0};
+  DeltaTest<uint32_t> v{{1, 2, 3}};
+  size_t len;
+  REQUIRE(cerealise::parse(v, buf, sizeof(buf), len));
+  REQUIRE(v.x.empty());
+  REQUIRE(len == 1);
+}
+
+TEST_CASE("delta packed iovec") {
+  // each block is copied before the next is packed into the same space
+  DeltaTest<uint64_t> v;
+  uint32_t state = 1;
+  for (size_t i = 0; i < 600; i++) {
+    state = state * 1664525 + 1013904223;
+    v.x.push_back((uint64_t)state << (i % 32));
+  }
+
+  std::vector<uint8_t> expected;
+  size_t len;
+  REQUIRE(cerealise::unparse(v, expected, len));
+
+  cerealise::IovecSink sink(16);
+  REQUIRE(cerealise::unparse(v, sink, len));
+  REQUIRE(len == expected.size());
+
+  std::vector<uint8_t> gathered;
+  for (auto &iov : sink.iovecs()) {
+    auto p = (const uint8_t *)iov.iov_base;
+    gathered.insert(gathered.end(), p, p + iov.iov_len);
+  }
+  REQUIRE(gathered == expected);
+
+  DeltaTest<uint64_t> parsed;
+  REQUIRE(cerealise::parse(parsed, gathered.data(), gathered.size(), len));
+  REQUIRE(parsed == v);
+}
+
+struct DeltaResourceTest {
+  std::pmr::vector<uint32_t> x;
+
+  template <typename T, typename F> static bool cerealise(T &v, F &f) {
+    return cerealise::delta_packed(f, v.x);
+  }
+};
+
+TEST_CASE("delta packed resource") {
+  DeltaResourceTest v;
+  for (uint32_t i = 0; i < 300; i++)
+    v.x.push_back(i * 3);
+  std::vector<uint8_t> buf;
+  size_t len;
+  REQUIRE(cerealise::unparse(v, buf, len));
+
+  std::pmr::monotonic_buffer_resource resource;
+  cerealise::ParseOptions options{.resource = &resource};
+  DeltaResourceTest parsed;
+  REQUIRE(cerealise::parse(parsed, buf.data(), buf.size(), len, options));
+  REQUIRE(parsed.x == v.x);
+  REQUIRE(parsed.x.get_allocator().resource() == &resource);
+
+  // the count is checked against the budget first
+  options.alloc_budget = 300 * sizeof(uint32_t) - 1;
+  DeltaResourceTest limited;
+  REQUIRE(!cerealise::parse(limited, buf.data(), buf.size(), len, options));
+}
+
+TEST_CASE("delta packed bad width") {
+  // count 3, first value 0, width 33
+  std::vector<uint8_t> buf{3, 0, 33, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+  DeltaTest<uint32_t> v;
+  size_t len;
+  REQUIRE(!cerealise::parse(v, buf.data(), buf.size(), len));
+}
+
+TEST_CASE("delta packed hostile length") {
+  // 2^28 values declared, with one block present
+  std::vector<uint8_t> buf{0x81, 0x80, 0x80, 0x80, 0x00, 0, 0};
+  DeltaTest<uint64_t> v;
+  size_t len;
+  REQUIRE(!cerealise::parse(v, buf.data(), buf.size(), len));
+  REQUIRE(v.x.capacity() == 0);
+}
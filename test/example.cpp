@@ -1,21 +1,26 @@
 #include "cerealise/cerealise.hpp"
 #include <cassert>
+#include <vector>
 
 struct Test {
   uint8_t x;
   uint32_t y;
 
-  template <typename T, typename F> static bool cerealise(T &value, F &f) {
+  template <typename T, typename F>
+  static constexpr bool cerealise(T &value, F &f) {
     return f(value.x) && f(value.y);
   }
 };
 
+template <> struct cerealise::FixedSizeTrait<Test> : std::true_type {};
+
 int main(int argc, char **argv) {
   // the value to serialise
   Test value{1, 999};
 
   // how many bytes do we need
   size_t len = cerealise::measure(value);
+  static_assert(cerealise::fixed_size_v<Test> == 5);
   assert(len);
 
   std::vector<uint8_t> buf(len);
@@ -0,0 +1,104 @@
+#include <array>
+#include <compare>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "cerealise/array.hpp"
+#include "cerealise/cerealise.hpp"
+#include "cerealise/optional.hpp"
+#include "cerealise/string.hpp"
+#include "cerealise/vector.hpp"
+#include "utils.hpp"
+
+struct FixedTest {
+  uint8_t x;
+  uint32_t y;
+  bool z;
+  std::array<double, 2> w;
+
+  auto operator<=>(const FixedTest &) const = default;
+
+  template <typename T, typename F>
+  static constexpr bool cerealise(T &v, F &f) {
+    return f(v.x) && f.template fixedint<3>(v.y) && f(v.z) && f(v.w);
+  }
+};
+
+template <> struct cerealise::FixedSizeTrait<FixedTest> : std::true_type {};
+
+// not declared fixed-size, so has the size of each value
+struct KindTest {
+  uint8_t kind;
+  uint32_t a;
+  uint32_t b;
+
+  template <typename T, typename F>
+  static constexpr bool cerealise(T &v, F &f) {
+    return f(v.kind) && f(v.a) && (v.kind != 1 || f(v.b));
+  }
+};
+
+TEST_CASE("fixed size") {
+  static_assert(cerealise::fixed_size_v<uint32_t> == 4);
+  static_assert(cerealise::fixed_size_v<bool> == 1);
+  static_assert(cerealise::fixed_size_v<FixedTest> == 1 + 3 + 1 + 16);
+  static_assert(cerealise::fixed_size_v<std::array<FixedTest, 3>> == 3 * 21);
+
+  static_assert(!cerealise::has_fixed_size_v<std::string>);
+  static_assert(!cerealise::has_fixed_size_v<std::vector<uint8_t>>);
+  static_assert(!cerealise::has_fixed_size_v<std::optional<uint8_t>>);
+  static_assert(!cerealise::has_fixed_size_v<KindTest>);
+  static_assert(!cerealise::has_fixed_size_v<std::array<KindTest, 2>>);
+
+  std::array<uint8_t, cerealise::fixed_size_v<FixedTest>> buf;
+  FixedTest v{1, 2, true, {3.0, 4.0}};
+  size_t len;
+  REQUIRE(cerealise::measure(v) == buf.size());
+  REQUIRE(cerealise::unparse(v, buf.data(), buf.size(), len));
+  REQUIRE(len == buf.size());
+}
+
+TEST_CASE("undeclared fixed size") {
+  REQUIRE(cerealise::measure(KindTest{0, 2, 3}) == 5);
+  REQUIRE(cerealise::measure(KindTest{1, 2, 3}) == 9);
+  REQUIRE(cerealise::measure(std::array<KindTest, 2>{}) == 10);
+}
+
+TEST_CASE("fixed size bounds") {
+  FixedTest v{1, 2, true, {3.0, 4.0}};
+  std::array<uint8_t, cerealise::fixed_size_v<FixedTest>> buf;
+  size_t len;
+  REQUIRE(!cerealise::unparse(v, buf.data(), buf.size() - 1, len));
+  REQUIRE(cerealise::unparse(v, buf.data(), buf.size(), len));
+
+  FixedTest v2;
+  REQUIRE(!cerealise::parse(v2, buf.data(), buf.size() - 1, len));
+  REQUIRE(cerealise::parse(v2, buf.data(), buf.size(), len));
+  REQUIRE(v == v2);
+
+  check_parse_unparse(std::vector<FixedTest>{v, v}, 1 + 2 * buf.size());
+}
+
+TEST_CASE("undeclared fixed size bounds") {
+  // the second field is only present for kind 1, so this must not be
+  // serialised with a single bounds check
+  KindTest v{1, 2, 3};
+  std::array<uint8_t, 9> buf;
+  size_t len;
+  REQUIRE(!cerealise::unparse(v, buf.data(), 5, len));
+  REQUIRE(cerealise::unparse(v, buf.data(), buf.size(), len));
+  REQUIRE(len == 9);
+
+  KindTest v2;
+  REQUIRE(!cerealise::parse(v2, buf.data(), 5, len));
+  REQUIRE(!cerealise::validate<KindTest>(buf.data(), 5, len));
+  REQUIRE(cerealise::parse(v2, buf.data(), buf.size(), len));
+  REQUIRE(len == 9);
+  REQUIRE(v2.b == 3);
+
+  std::array<KindTest, 1> a{v};
+  REQUIRE(!cerealise::unparse(a, buf.data(), 5, len));
+  REQUIRE(!cerealise::parse(a, buf.data(), 5, len));
+}
@@ -0,0 +1,27 @@
+// declaring a type with FixedSizeTrait when its size can not be found must
+// not compile; this is built by the fixed_size_fail tests
+#include "cerealise/cerealise.hpp"
+
+struct Test {
+  uint32_t x;
+
+#ifdef FIXED_SIZE_FAIL_VARINT
+  template <typename T, typename F>
+  static constexpr bool cerealise(T &v, F &f) {
+    return f.varint(v.x);
+  }
+#else
+  template <typename T, typename F> static bool cerealise(T &v, F &f) {
+    return f(v.x);
+  }
+#endif
+};
+
+template <> struct cerealise::FixedSizeTrait<Test> : std::true_type {};
+
+int main() {
+  Test v{1};
+  uint8_t buf[10];
+  size_t len;
+  return cerealise::unparse(v, buf, sizeof(buf), len) ? 0 : 1;
+}
@@ -0,0 +1,167 @@
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "cerealise/cerealise.hpp"
+#include "cerealise/framing.hpp"
+#include "cerealise/string.hpp"
+#include "cerealise/vector.hpp"
+
+struct FrameTest {
+  std::string s;
+  uint32_t x;
+
+  bool operator==(const FrameTest &) const = default;
+
+  template <typename T, typename F>
+  static constexpr bool cerealise(T &v, F &f) {
+    return f(v.s) && f(v.x);
+  }
+};
+
+static const std::vector<FrameTest> values = {
+    {"", 1},
+    {std::string(200, 'a'), 2}, // long enough for a 2-byte varint prefix
+    {std::string(20000, 'b'), 3},
+    {"c", 4},
+};
+
+/// check that frames in buf contain values, giving the reader more of buf
+/// one byte at a time, and checking that needed() never over-estimates
+template <typename Prefix> void check_reader(std::vector<uint8_t> &buf) {
+  std::vector<uint8_t> received;
+  size_t n_read = 0;
+
+  for (size_t i = 0; i < buf.size();) {
+    cerealise::FrameReader<Prefix> reader(received.data(), received.size());
+
+    const uint8_t *body;
+    size_t body_len;
+    while (reader.next(body, body_len)) {
+      FrameTest v;
+      size_t len;
+      REQUIRE(cerealise::parse(v, body, body_len, len));
+      REQUIRE(len == body_len);
+      REQUIRE(v == values[n_read++]);
+    }
+    REQUIRE(!reader.error());
+    REQUIRE(reader.needed() > 0);
+
+    received.erase(received.begin(), received.begin() + reader.consumed());
+    size_t n = std::min(reader.needed(), buf.size() - i);
+    received.insert(received.end(), buf.begin() + i, buf.begin() + i + n);
+    i += n;
+  }
+
+  cerealise::FrameReader<Prefix> reader(received.data(), received.size());
+  const uint8_t *body;
+  size_t body_len;
+  REQUIRE(reader.next(body, body_len));
+  n_read++;
+  REQUIRE(n_read == values.size());
+  REQUIRE(reader.consumed() == received.size());
+}
+
+/// prefix_size gives the size of the prefix for a body of n bytes
+template <typename Prefix, typename PrefixSize>
+void check_framing(PrefixSize prefix_size) {
+  std::vector<uint8_t> buf;
+  for (auto &v : values) {
+    size_t old_size = buf.size(), len;
+    REQUIRE(cerealise::unparse_framed<Prefix>(v, buf, len));
+    size_t body_len = cerealise::measure(v);
+    REQUIRE(len == buf.size() - old_size);
+    REQUIRE(len == body_len + prefix_size(body_len));
+
+    // the same through the pointer interface
+    std::vector<uint8_t> mem(len);
+    size_t mem_len;
+    REQUIRE(cerealise::unparse_framed<Prefix>(v, mem.data(), len, mem_len));
+    REQUIRE(mem_len == len);
+    REQUIRE(std::equal(mem.begin(), mem.end(), buf.begin() + old_size));
+    REQUIRE(!cerealise::unparse_framed<Prefix>(v, mem.data(), len - 1,
+                                               mem_len));
+  }
+
+  check_reader<Prefix>(buf);
+}
+
+TEST_CASE("framing") {
+  check_framing<cerealise::VarintPrefix>(
+      [](size_t n) { return cerealise::detail::varint_length(n); });
+  check_framing<cerealise::PaddedVarintPrefix>(
+      [](size_t) { return cerealise::VarintPrefix::max_size; });
+  check_framing<cerealise::FixedPrefix<4>>([](size_t) { return 4; });
+  check_framing<cerealise::FixedPrefix<8>>([](size_t) { return 8; });
+}
+
+TEST_CASE("framing prefix format") {
+  std::vector<uint8_t> buf;
+  size_t len;
+  uint16_t x = 0x0102;
+
+  REQUIRE(cerealise::unparse_framed<cerealise::FixedPrefix<4>>(x, buf, len));
+  REQUIRE(buf == std::vector<uint8_t>{0, 0, 0, 2, 1, 2});
+
+  buf.clear();
+  REQUIRE(cerealise::unparse_framed<cerealise::FixedPrefix<3>,
+                                    cerealise::LittleEndian>(x, buf, len));
+  REQUIRE(buf == std::vector<uint8_t>{2, 0, 0, 2, 1});
+
+  // varints are as short as possible
+  buf.clear();
+  REQUIRE(cerealise::unparse_framed(std::string("hi"), buf, len));
+  REQUIRE(buf == std::vector<uint8_t>{3, 2, 'h', 'i'});
+
+  // a buffer with only enough space for the shortest prefix
+  uint8_t mem[4];
+  REQUIRE(cerealise::unparse_framed(std::string("hi"), mem, sizeof(mem), len));
+  REQUIRE(std::vector<uint8_t>(mem, mem + len) == buf);
+
+  buf.clear();
+  REQUIRE(cerealise::unparse_framed(std::string(300, 'x'), buf, len));
+  REQUIRE(len == 2 + 2 + 300);
+  REQUIRE(std::vector<uint8_t>(buf.begin(), buf.begin() + 4) ==
+          std::vector<uint8_t>{0x82, 0x2e, 0x82, 0x2c});
+
+
+  // padded varints are padded with zero groups, unless the value has a
+  // fixed size
+  buf.clear();
+  REQUIRE(cerealise::unparse_framed<cerealise::PaddedVarintPrefix>(
+      std::string(300, 'x'), buf, len));
+  REQUIRE(len == 10 + 2 + 300);
+  REQUIRE(std::vector<uint8_t>(buf.begin(), buf.begin() + 10) ==
+          std::vector<uint8_t>{0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+                               0x82, 0x2e});
+
+  buf.clear();
+  REQUIRE(cerealise::unparse_framed<cerealise::PaddedVarintPrefix>(x, buf,
+                                                                   len));
+  REQUIRE(buf == std::vector<uint8_t>{2, 1, 2});
+}
+
+TEST_CASE("framing errors") {
+  // body too long for the prefix; buf is left alone
+  std::vector<uint8_t> buf{1, 2, 3};
+  size_t len;
+  REQUIRE(!cerealise::unparse_framed<cerealise::FixedPrefix<1>>(
+      std::string(300, 'x'), buf, len));
+  REQUIRE(buf == std::vector<uint8_t>{1, 2, 3});
+
+  const uint8_t *body;
+  size_t body_len;
+
+  // body longer than allowed
+  std::vector<uint8_t> big{0x88, 0x00}; // 1024
+  cerealise::FrameReader<> limited(big.data(), big.size(), 1000);
+  REQUIRE(!limited.next(body, body_len));
+  REQUIRE(limited.error());
+
+  // varint prefix which is too long
+  std::vector<uint8_t> corrupt(16, 0xff);
+  cerealise::FrameReader<> reader(corrupt.data(), corrupt.size());
+  REQUIRE(!reader.next(body, body_len));
+  REQUIRE(reader.error());
+  REQUIRE(!reader.next(body, body_len));
+}
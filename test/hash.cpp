@@ -0,0 +1,71 @@
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "cerealise/cerealise.hpp"
+#include "cerealise/hash.hpp"
+#include "cerealise/string.hpp"
+#include "cerealise/vector.hpp"
+
+static uint64_t xxh64(const std::string &s, uint64_t seed = 0) {
+  cerealise::detail::XXHash64 hasher(seed);
+  hasher.update((const uint8_t *)s.data(), s.size());
+  return hasher.digest();
+}
+
+TEST_CASE("xxh64") {
+  REQUIRE(xxh64("") == 0xef46db3751d8e999);
+  REQUIRE(xxh64("a") == 0xd24ec4f1a98c6e5b);
+  REQUIRE(xxh64("abc") == 0x44bc2cf5ad770999);
+
+  // the result does not depend on how the input is split up
+  std::string long_input;
+  for (size_t i = 0; i < 1000; i++)
+    long_input.push_back((char)(i * 7));
+  for (size_t chunk : {1, 3, 31, 32, 33, 100}) {
+    cerealise::detail::XXHash64 hasher(5);
+    for (size_t i = 0; i < long_input.size(); i += chunk) {
+      size_t n = std::min(chunk, long_input.size() - i);
+      hasher.update((const uint8_t *)long_input.data() + i, n);
+    }
+    REQUIRE(hasher.digest() == xxh64(long_input, 5));
+  }
+}
+
+struct HashTest {
+  uint32_t a;
+  std::string b;
+  std::vector<uint16_t> c;
+  std::vector<int64_t> d; // varints
+
+  template <typename T, typename F> static bool cerealise(T &v, F &f) {
+    size_t d_size = v.d.size();
+    return f(v.a) && f(v.b) && f(v.c) && f.varint(d_size) &&
+           f.varints(v.d.data(), d_size);
+  }
+};
+
+template <typename Format = cerealise::BigEndian>
+void check_hash(const HashTest &v, uint64_t seed) {
+  std::vector<uint8_t> buf;
+  size_t len;
+  REQUIRE(cerealise::unparse<Format>(v, buf, len));
+  std::string bytes(buf.begin(), buf.end());
+  REQUIRE(cerealise::hash<Format>(v, seed) == xxh64(bytes, seed));
+}
+
+TEST_CASE("hash matches unparse") {
+  check_hash({}, 0);
+  check_hash({1, "short", {1, 2}, {-1, 1}}, 0);
+
+  HashTest big{0xdeadbeef, std::string(1000, 'x'), {}, {}};
+  for (size_t i = 0; i < 5000; i++) {
+    big.c.push_back(i * 3);
+    big.d.push_back((int64_t)i * i * (i % 2 ? -1 : 1));
+  }
+  check_hash(big, 0);
+  check_hash(big, 12345);
+  check_hash<cerealise::LittleEndian>(big, 12345);
+
+  REQUIRE(cerealise::hash(big) != cerealise::hash(big, 1));
+}
@@ -0,0 +1,131 @@
+#include <compare>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "cerealise/cerealise.hpp"
+#include "cerealise/many.hpp"
+#include "cerealise/string.hpp"
+#include "cerealise/vector.hpp"
+
+struct ManyTest {
+  std::string s;
+  std::vector<uint32_t> x;
+
+  auto operator<=>(const ManyTest &) const = default;
+
+  template <typename T, typename F>
+  static constexpr bool cerealise(T &v, F &f) {
+    return f(v.s) && f(v.x);
+  }
+};
+
+static std::vector<ManyTest> make_values(size_t n) {
+  std::vector<ManyTest> values(n);
+  for (size_t i = 0; i < n; i++) {
+    values[i].s = std::string(i % 50, 'a' + i % 26);
+    values[i].x.resize(i % 7, (uint32_t)i);
+  }
+  return values;
+}
+
+template <typename T> void check_many(const std::vector<T> &values) {
+  // serial reference, after some existing data
+  std::vector<uint8_t> expected{1, 2, 3};
+  for (auto &v : values) {
+    size_t len;
+    REQUIRE(cerealise::unparse(v, expected, len));
+  }
+
+  for (unsigned n_threads : {0u, 1u, 3u, 8u}) {
+    std::vector<uint8_t> buf{1, 2, 3};
+    std::vector<size_t> offsets;
+    REQUIRE(cerealise::unparse_many(values.data(), values.size(), buf, offsets,
+                                    n_threads));
+    REQUIRE(buf == expected);
+    REQUIRE(offsets.size() == values.size() + 1);
+    REQUIRE(offsets.front() == 3);
+    REQUIRE(offsets.back() == buf.size());
+
+    std::vector<T> parsed(values.size());
+    REQUIRE(cerealise::parse_many(parsed.data(), parsed.size(), buf.data(),
+                                  buf.size(), offsets.data(), n_threads));
+    REQUIRE(parsed == values);
+
+    std::vector<size_t> index;
+    REQUIRE(cerealise::index_many<T>(buf.data() + 3, buf.size() - 3,
+                                     values.size(), index));
+    for (size_t i = 0; i < index.size(); i++)
+      REQUIRE(index[i] + 3 == offsets[i]);
+  }
+}
+
+TEST_CASE("many") {
+  for (size_t n : {0, 1, 255, 1000, 10000})
+    check_many(make_values(n));
+
+  std::vector<uint64_t> fixed(5000);
+  for (size_t i = 0; i < fixed.size(); i++)
+    fixed[i] = i * 0x123456789;
+  check_many(fixed);
+}
+
+/// Executor which runs each task in turn on the calling thread, like a pool
+/// with one worker, and counts them
+struct CountingExecutor {
+  size_t tasks = 0;
+
+  size_t concurrency() const { return 4; }
+
+  void run(size_t n, const std::function<void(size_t)> &task) {
+    for (size_t i = 0; i < n; i++, tasks++)
+      task(i);
+  }
+};
+
+TEST_CASE("many executor") {
+  auto values = make_values(10000);
+  std::vector<uint8_t> expected, buf;
+  std::vector<size_t> expected_offsets, offsets;
+  REQUIRE(cerealise::unparse_many(values.data(), values.size(), expected,
+                                  expected_offsets, 1));
+
+  CountingExecutor executor;
+  REQUIRE(cerealise::unparse_many(values.data(), values.size(), buf, offsets,
+                                  executor));
+  REQUIRE(buf == expected);
+  REQUIRE(offsets == expected_offsets);
+  // measuring, finding offsets and unparsing, with one task per run
+  REQUIRE(executor.tasks == 3 * 4);
+
+  std::vector<ManyTest> parsed(values.size());
+  REQUIRE(cerealise::parse_many(parsed.data(), parsed.size(), buf.data(),
+                                buf.size(), offsets.data(), executor));
+  REQUIRE(parsed == values);
+  REQUIRE(executor.tasks == 4 * 4);
+}
+
+TEST_CASE("many errors") {
+  auto values = make_values(2000);
+  std::vector<uint8_t> buf;
+  std::vector<size_t> offsets;
+  REQUIRE(cerealise::unparse_many(values.data(), values.size(), buf, offsets));
+
+  std::vector<ManyTest> parsed(values.size());
+
+  // offsets which do not match the values
+  auto bad = offsets;
+  bad[1000]++;
+  REQUIRE(!cerealise::parse_many(parsed.data(), parsed.size(), buf.data(),
+                                 buf.size(), bad.data()));
+
+  // offsets past the end of the buffer
+  REQUIRE(!cerealise::parse_many(parsed.data(), parsed.size(), buf.data(),
+                                 buf.size() - 1, offsets.data()));
+
+  // not enough values
+  std::vector<size_t> index;
+  REQUIRE(!cerealise::index_many<ManyTest>(buf.data(), buf.size(),
+                                           values.size() + 1, index));
+}
@@ -0,0 +1,169 @@
+#include <compare>
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "catch.hpp"
+#include "cerealise/cerealise.hpp"
+#include "cerealise/framing.hpp"
+#include "cerealise/mmap.hpp"
+#include "cerealise/string.hpp"
+#include "cerealise/vector.hpp"
+
+struct RecordTest {
+  std::string s;
+  uint32_t x;
+
+  auto operator<=>(const RecordTest &) const = default;
+
+  template <typename T, typename F>
+  static constexpr bool cerealise(T &v, F &f) {
+    return f(v.s) && f(v.x);
+  }
+};
+
+/// a temporary file which is removed at the end of the test
+struct TempFile {
+  char path[32] = "/tmp/cerealise-XXXXXX";
+
+  TempFile() {
+    int fd = mkstemp(path);
+    REQUIRE(fd >= 0);
+    close(fd);
+  }
+  ~TempFile() { unlink(path); }
+
+  void write(const std::vector<uint8_t> &data) {
+    FILE *file = fopen(path, "wb");
+    REQUIRE(file);
+    REQUIRE(fwrite(data.data(), 1, data.size(), file) == data.size());
+    REQUIRE(fclose(file) == 0);
+  }
+};
+
+static std::vector<RecordTest> make_records() {
+  std::vector<RecordTest> records;
+  for (uint32_t i = 0; i < 1000; i++)
+    records.push_back({std::string(i % 300, 'a' + i % 26), i});
+  return records;
+}
+
+static std::vector<uint8_t> frame_records(const std::vector<RecordTest> &rs) {
+  std::vector<uint8_t> buf;
+  for (auto &r : rs) {
+    size_t len;
+    REQUIRE(cerealise::unparse_framed(r, buf, len));
+  }
+  return buf;
+}
+
+static void check_records(const cerealise::RecordFile<> &file,
+                          const std::vector<RecordTest> &records) {
+  REQUIRE(file.size() == records.size());
+  for (size_t i = records.size(); i-- > 0;) {
+    RecordTest r;
+    REQUIRE(file.parse(i, r));
+    REQUIRE(r == records[i]);
+  }
+  RecordTest r;
+  REQUIRE(!file.parse(records.size(), r));
+}
+
+TEST_CASE("record file") {
+  auto records = make_records();
+  TempFile data, index;
+  data.write(frame_records(records));
+
+  cerealise::RecordFile<> file;
+  REQUIRE(file.open(data.path));
+  REQUIRE(file.build_index());
+  check_records(file, records);
+  REQUIRE(file.save_index(index.path));
+
+  cerealise::RecordFile<> loaded;
+  REQUIRE(loaded.open(data.path));
+  REQUIRE(loaded.load_index(index.path));
+  check_records(loaded, records);
+
+  // the index does not match a different file
+  records.pop_back();
+  TempFile other;
+  other.write(frame_records(records));
+  REQUIRE(loaded.open(other.path));
+  REQUIRE(!loaded.load_index(index.path));
+  REQUIRE(loaded.size() == 0);
+  REQUIRE(loaded.build_index());
+  check_records(loaded, records);
+}
+
+TEST_CASE("record file errors") {
+  cerealise::RecordFile<> file;
+  REQUIRE(!file.open("/nonexistent/cerealise"));
+
+  // empty
+  TempFile data;
+  REQUIRE(file.open(data.path));
+  REQUIRE(file.build_index());
+  REQUIRE(file.size() == 0);
+
+  // truncated
+  auto buf = frame_records(make_records());
+  buf.pop_back();
+  data.write(buf);
+  REQUIRE(file.open(data.path));
+  REQUIRE(!file.build_index());
+  REQUIRE(file.size() == 0);
+
+  // record too long
+  buf.push_back(0);
+  data.write(buf);
+  REQUIRE(file.open(data.path));
+  REQUIRE(!file.build_index(100));
+  REQUIRE(file.build_index());
+}
+
+TEST_CASE("mapped file sink") {
+  TempFile data;
+
+  // enough to grow the file a few times
+  std::vector<RecordTest> records = make_records();
+  std::vector<uint32_t> big(1000000);
+  for (size_t i = 0; i < big.size(); i++)
+    big[i] = (uint32_t)i;
+
+  std::vector<uint8_t> expected;
+  size_t len;
+
+  cerealise::MappedFileSink sink;
+  REQUIRE(sink.open(data.path));
+  for (auto &r : records) {
+    REQUIRE(cerealise::unparse(r, sink, len));
+    REQUIRE(cerealise::unparse(r, expected, len));
+  }
+  REQUIRE(cerealise::unparse(big, sink, len));
+  REQUIRE(cerealise::unparse(big, expected, len));
+  REQUIRE(sink.flush());
+  REQUIRE(sink.sync());
+  REQUIRE(sink.size() == expected.size());
+  REQUIRE(sink.close());
+
+  FILE *file = fopen(data.path, "rb");
+  REQUIRE(file);
+  std::vector<uint8_t> contents(expected.size() + 1);
+  REQUIRE(fread(contents.data(), 1, contents.size(), file) == expected.size());
+  fclose(file);
+  contents.pop_back();
+  REQUIRE(contents == expected);
+
+  // nothing written
+  REQUIRE(sink.open(data.path));
+  REQUIRE(sink.close());
+  file = fopen(data.path, "rb");
+  REQUIRE(file);
+  REQUIRE(fgetc(file) == EOF);
+  fclose(file);
+
+  REQUIRE(!sink.open("/nonexistent/cerealise"));
+  REQUIRE(!cerealise::unparse(records[0], sink, len));
+}
@@ -0,0 +1,203 @@
+#include <array>
+#include <compare>
+#include <functional>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "cerealise/array.hpp"
+#include "cerealise/cerealise.hpp"
+#include "cerealise/hash.hpp"
+#include "cerealise/parallel.hpp"
+#include "cerealise/stream.hpp"
+#include "cerealise/string.hpp"
+#include "cerealise/vector.hpp"
+
+template <typename T> struct ParallelTest {
+  uint8_t header;
+  std::vector<T> values;
+  uint8_t footer;
+
+  bool operator==(const ParallelTest &) const = default;
+
+  template <typename TT, typename F> static bool cerealise(TT &v, F &f) {
+    return f(v.header) && cerealise::parallel_vector(f, v.values, 4) &&
+           f(v.footer);
+  }
+};
+
+template <typename T> struct SerialTest {
+  uint8_t header;
+  std::vector<T> values;
+  uint8_t footer;
+
+  template <typename TT, typename F> static bool cerealise(TT &v, F &f) {
+    return f(v.header) && f(v.values) && f(v.footer);
+  }
+};
+
+template <typename T> void check_parallel(std::vector<T> values) {
+  ParallelTest<T> v{1, values, 2};
+  SerialTest<T> serial{1, values, 2};
+
+  // the same format as the normal adapter, through each kind of buffer
+  std::vector<uint8_t> expected, buf;
+  size_t len;
+  REQUIRE(cerealise::unparse(serial, expected, len));
+  REQUIRE(cerealise::unparse(v, buf, len));
+  REQUIRE(buf == expected);
+  REQUIRE(cerealise::measure(v) == expected.size());
+  REQUIRE(cerealise::hash(v) == cerealise::hash(serial));
+
+  std::vector<uint8_t> mem(expected.size());
+  REQUIRE(cerealise::unparse(v, mem.data(), mem.size(), len));
+  REQUIRE(mem == expected);
+  REQUIRE(!cerealise::unparse(v, mem.data(), mem.size() - 1, len));
+
+  ParallelTest<T> parsed;
+  REQUIRE(cerealise::parse(parsed, buf.data(), buf.size(), len));
+  REQUIRE(len == buf.size());
+  REQUIRE(parsed == v);
+  REQUIRE(!cerealise::parse(parsed, buf.data(), buf.size() - 1, len));
+
+  size_t skipped;
+  REQUIRE(cerealise::skip<ParallelTest<T>>(buf.data(), buf.size(), skipped));
+  REQUIRE(skipped == buf.size());
+
+  // a sink with small windows falls back to unparsing serially
+  FILE *file = tmpfile();
+  REQUIRE(file);
+  uint8_t file_buf[4096];
+  cerealise::FileSink sink(file, file_buf, sizeof(file_buf));
+  REQUIRE(cerealise::unparse(v, sink, len));
+  REQUIRE(sink.flush());
+  REQUIRE(len == expected.size());
+  rewind(file);
+  std::vector<uint8_t> from_file(expected.size());
+  REQUIRE(fread(from_file.data(), 1, from_file.size(), file) == len);
+  REQUIRE(from_file == expected);
+  fclose(file);
+}
+
+TEST_CASE("parallel vector") {
+  for (size_t n : {0, 100, 1000000}) {
+    std::vector<uint32_t> ints(n);
+    for (size_t i = 0; i < n; i++)
+      ints[i] = (uint32_t)(i * 2654435761u);
+    check_parallel(ints);
+
+    static_assert(cerealise::has_fixed_size_v<std::array<uint16_t, 3>>);
+    std::vector<std::array<uint16_t, 3>> fixed(n / 4);
+    for (size_t i = 0; i < fixed.size(); i++)
+      fixed[i] = {(uint16_t)i, (uint16_t)(i * 3), (uint16_t)(i * 7)};
+    check_parallel(fixed);
+
+    std::vector<std::string> strings(n / 20);
+    for (size_t i = 0; i < strings.size(); i++)
+      strings[i] = std::string(i % 30, 'a' + i % 26);
+    check_parallel(strings);
+  }
+}
+
+/// Executor which runs each task in turn on the calling thread, and counts
+/// them
+struct CountingExecutor {
+  size_t tasks = 0;
+
+  size_t concurrency() const { return 4; }
+
+  void run(size_t n, const std::function<void(size_t)> &task) {
+    for (size_t i = 0; i < n; i++, tasks++)
+      task(i);
+  }
+};
+
+static CountingExecutor counting_executor;
+
+struct ExecutorTest {
+  std::vector<std::string> values;
+
+  bool operator==(const ExecutorTest &) const = default;
+
+  template <typename T, typename F> static bool cerealise(T &v, F &f) {
+    return cerealise::parallel_vector(f, v.values, counting_executor);
+  }
+};
+
+TEST_CASE("parallel vector executor") {
+  ExecutorTest v{std::vector<std::string>(100000, "abc")};
+  std::vector<uint8_t> buf;
+  size_t len;
+  REQUIRE(cerealise::unparse(v, buf, len));
+  // measuring then unparsing, with one task per run
+  REQUIRE(counting_executor.tasks == 2 * 4);
+  REQUIRE(buf.size() == cerealise::measure(v.values));
+
+  ExecutorTest parsed;
+  REQUIRE(cerealise::parse(parsed, buf.data(), buf.size(), len));
+  REQUIRE(parsed == v);
+  REQUIRE(counting_executor.tasks == 3 * 4);
+}
+
+TEST_CASE("parallel vector budget") {
+  std::vector<std::string> strings(100000, std::string(100, 'x'));
+  ParallelTest<std::string> v{1, strings, 2};
+  std::vector<uint8_t> buf;
+  size_t len;
+  REQUIRE(cerealise::unparse(v, buf, len));
+
+  // the outer vector and the strings need about 13MB between them
+  size_t outer = strings.size() * sizeof(std::string);
+  cerealise::ParseOptions options;
+  options.alloc_budget = outer + 100 * strings.size();
+
+  ParallelTest<std::string> parsed;
+  REQUIRE(cerealise::parse(parsed, buf.data(), buf.size(), len, options));
+  REQUIRE(parsed == v);
+
+  options.alloc_budget = outer + 50 * strings.size();
+  REQUIRE(!cerealise::parse(parsed, buf.data(), buf.size(), len, options));
+}
+
+TEST_CASE("parallel vector skewed budget") {
+  // all of the allocations are in the first run, which must be able to use
+  // the whole budget
+  std::vector<std::string> strings(100000);
+  for (size_t i = 0; i < 1000; i++)
+    strings[i] = std::string(10000, 'x');
+  ParallelTest<std::string> v{1, strings, 2};
+  std::vector<uint8_t> buf;
+  size_t len;
+  REQUIRE(cerealise::unparse(v, buf, len));
+
+  size_t outer = strings.size() * sizeof(std::string);
+  cerealise::ParseOptions options;
+  options.alloc_budget = outer + 10000 * 1000;
+
+  ParallelTest<std::string> parsed;
+  REQUIRE(cerealise::parse(parsed, buf.data(), buf.size(), len, options));
+  REQUIRE(parsed == v);
+
+  options.alloc_budget--;
+  REQUIRE(!cerealise::parse(parsed, buf.data(), buf.size(), len, options));
+}
+
+TEST_CASE("parallel vector resource") {
+  // memory resources are not thread-safe, so this is parsed on one thread
+  std::vector<std::pmr::string> strings(100000, std::pmr::string(100, 'x'));
+  ParallelTest<std::pmr::string> v{1, strings, 2};
+  std::vector<uint8_t> buf;
+  size_t len;
+  REQUIRE(cerealise::unparse(v, buf, len));
+
+  std::pmr::monotonic_buffer_resource resource;
+  cerealise::ParseOptions options;
+  options.resource = &resource;
+
+  ParallelTest<std::pmr::string> parsed;
+  REQUIRE(cerealise::parse(parsed, buf.data(), buf.size(), len, options));
+  REQUIRE(parsed == v);
+  for (auto &s : parsed.values)
+    REQUIRE(s.get_allocator().resource() == &resource);
+}
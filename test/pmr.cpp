@@ -0,0 +1,68 @@
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "cerealise/cerealise.hpp"
+#include "cerealise/string.hpp"
+#include "cerealise/vector.hpp"
+#include "utils.hpp"
+
+struct PmrInner {
+  std::pmr::string name;
+  std::pmr::vector<uint32_t> values;
+
+  template <typename T, typename F> static bool cerealise(T &v, F &f) {
+    return f(v.name) && f(v.values);
+  }
+
+  bool operator==(const PmrInner &) const = default;
+};
+
+struct PmrOuter {
+  std::pmr::vector<PmrInner> inner;
+  std::pmr::vector<std::pmr::string> names;
+
+  template <typename T, typename F> static bool cerealise(T &v, F &f) {
+    return f(v.inner) && f(v.names);
+  }
+
+  bool operator==(const PmrOuter &) const = default;
+};
+
+TEST_CASE("pmr containers") {
+  check_parse_unparse(std::pmr::string("a long string, not stored inline"));
+  check_parse_unparse(std::pmr::vector<uint16_t>{1, 2, 3});
+}
+
+TEST_CASE("pmr parse with resource") {
+  PmrOuter v1;
+  v1.inner.push_back({"first name, long enough to allocate", {1, 2, 3}});
+  v1.inner.push_back({"second", {4}});
+  v1.names = {"x", "a long name which needs an allocation"};
+
+  std::vector<uint8_t> buf;
+  size_t len;
+  REQUIRE(cerealise::unparse(v1, buf, len));
+
+  // everything must come from arena; anything else would throw
+  uint8_t arena[4096];
+  std::pmr::monotonic_buffer_resource resource(
+      arena, sizeof(arena), std::pmr::null_memory_resource());
+
+  cerealise::ParseOptions options;
+  options.resource = &resource;
+
+  PmrOuter v2;
+  REQUIRE(cerealise::parse(v2, buf.data(), buf.size(), len, options));
+  REQUIRE(v2 == v1);
+
+  REQUIRE(v2.inner.get_allocator().resource() == &resource);
+  REQUIRE(v2.names.get_allocator().resource() == &resource);
+  for (auto &inner : v2.inner) {
+    REQUIRE(inner.name.get_allocator().resource() == &resource);
+    REQUIRE(inner.values.get_allocator().resource() == &resource);
+  }
+  for (auto &name : v2.names)
+    REQUIRE(name.get_allocator().resource() == &resource);
+}
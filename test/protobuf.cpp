@@ -0,0 +1,177 @@
+#include <compare>
+#include <optional>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "catch.hpp"
+#include "cerealise/cerealise.hpp"
+#include "cerealise/protobuf.hpp"
+
+template <typename T>
+void check_protobuf(const T &v1, const std::vector<uint8_t> &expected) {
+  size_t len = cerealise::measure_protobuf(v1);
+  REQUIRE(len == expected.size());
+
+  std::vector<uint8_t> buf(len);
+  size_t real_len;
+  REQUIRE(cerealise::unparse_protobuf(v1, buf.data(), buf.size(), real_len));
+  REQUIRE(real_len == len);
+  REQUIRE(buf == expected);
+
+  T v2;
+  REQUIRE(cerealise::parse_protobuf(v2, buf.data(), buf.size()));
+  REQUIRE(v1 == v2);
+}
+
+struct PbScalars {
+  uint32_t a; // varint
+  int32_t b;  // sint32
+  uint32_t c; // fixed32
+  double d;
+  bool e;
+
+  template <typename T, typename F> static bool cerealise(T &v, F &f) {
+    return f.varint(v.a) && f.varint(v.b) && f(v.c) && f(v.d) && f(v.e);
+  }
+
+  auto operator<=>(const PbScalars &) const = default;
+};
+
+TEST_CASE("protobuf scalars") {
+  check_protobuf(PbScalars{150, -2, 1, 1.0, true},
+                 {0x08, 0x96, 0x01,                   // 1: 150
+                  0x10, 0x03,                         // 2: zigzag(-2)
+                  0x1d, 0x01, 0x00, 0x00, 0x00,       // 3: fixed32 1
+                  0x21, 0, 0, 0, 0, 0, 0, 0xf0, 0x3f, // 4: double 1.0
+                  0x28, 0x01});                       // 5: true
+}
+
+struct PbInner {
+  std::string name;
+  std::vector<uint16_t> values;
+
+  template <typename T, typename F> static bool cerealise(T &v, F &f) {
+    return f(v.name) && f(v.values);
+  }
+
+  auto operator<=>(const PbInner &) const = default;
+};
+
+struct PbOuter {
+  PbInner inner;
+  std::vector<PbInner> many;
+  std::optional<uint8_t> opt;
+  std::variant<uint8_t, std::string> oneof;
+  uint8_t last;
+
+  template <typename T, typename F> static bool cerealise(T &v, F &f) {
+    return f(v.inner) && f(v.many) && f(v.opt) && f(v.oneof) && f(v.last);
+  }
+
+  auto operator<=>(const PbOuter &) const = default;
+};
+
+TEST_CASE("protobuf nested") {
+  check_protobuf(PbInner{"ab", {1, 300}},
+                 {0x0a, 0x02, 'a', 'b',               // 1: "ab"
+                  0x12, 0x03, 0x01, 0xac, 0x02});     // 2: packed [1, 300]
+
+  check_protobuf(PbOuter{{"a", {}}, {{"", {2}}, {"b", {}}}, {}, "x", 7},
+                 {0x0a, 0x03, 0x0a, 0x01, 'a',        // 1: {"a"}
+                  0x12, 0x05, 0x0a, 0x00, 0x12, 0x01, 0x02, // 2: {"", [2]}
+                  0x12, 0x03, 0x0a, 0x01, 'b',        // 2: {"b"}
+                  // 3: opt not present
+                  0x2a, 0x01, 'x',                    // 5: oneof string
+                  0x30, 0x07});                       // 6: 7
+
+  check_protobuf(PbOuter{{}, {}, 5, (uint8_t)3, 0},
+                 {0x0a, 0x02, 0x0a, 0x00,             // 1: {""}
+                  0x18, 0x05,                         // 3: 5
+                  0x20, 0x03,                         // 4: oneof uint8_t
+                  0x30, 0x00});                       // 6: 0
+}
+
+TEST_CASE("protobuf parse other encodings") {
+  PbInner v;
+  // fields out of order, an unknown field, and unpacked repeated values
+  std::vector<uint8_t> buf{0x10, 0x05,             // 2: 5
+                           0x38, 0x01,             // 7: unknown
+                           0x0a, 0x01, 'z',        // 1: "z"
+                           0x12, 0x01, 0x06};      // 2: packed [6]
+  REQUIRE(cerealise::parse_protobuf(v, buf.data(), buf.size()));
+  REQUIRE(v == PbInner{"z", {5, 6}});
+
+  // missing fields get default values
+  PbScalars s{1, 2, 3, 4.0, true};
+  REQUIRE(cerealise::parse_protobuf(s, buf.data(), 0));
+  REQUIRE(s == PbScalars{});
+}
+
+struct PbDeep {
+  std::vector<PbOuter> outers;
+  std::optional<PbOuter> opt;
+  PbInner after;
+
+  template <typename T, typename F> static bool cerealise(T &v, F &f) {
+    return f(v.outers) && f(v.opt) && f(v.after);
+  }
+
+  auto operator<=>(const PbDeep &) const = default;
+};
+
+TEST_CASE("protobuf deeply nested") {
+  // nested messages at several levels, next to each other, with their sizes
+  // cached while writing
+  PbOuter outer{{"a", {1}}, {{"bc", {2, 300}}, {}}, 4, "d", 5};
+  PbDeep v1{{outer, {}, outer}, outer, {"e", {6}}};
+
+  size_t len = cerealise::measure_protobuf(v1);
+  REQUIRE(len > 0);
+  std::vector<uint8_t> buf(len);
+  size_t real_len;
+  REQUIRE(cerealise::unparse_protobuf(v1, buf.data(), buf.size(), real_len));
+  REQUIRE(real_len == len);
+
+  PbDeep v2;
+  REQUIRE(cerealise::parse_protobuf(v2, buf.data(), buf.size()));
+  REQUIRE(v1 == v2);
+
+  // writing again gives the same output
+  std::vector<uint8_t> buf2(len);
+  REQUIRE(cerealise::unparse_protobuf(v1, buf2.data(), buf2.size(), real_len));
+  REQUIRE(buf2 == buf);
+}
+
+TEST_CASE("protobuf parse oneof order") {
+  // the last alternative in the message wins, even if it has a lower number
+  PbOuter v;
+  std::vector<uint8_t> buf{0x2a, 0x01, 'x', // 5: oneof string
+                           0x20, 0x03};     // 4: oneof uint8_t
+  REQUIRE(cerealise::parse_protobuf(v, buf.data(), buf.size()));
+  REQUIRE(v.oneof == std::variant<uint8_t, std::string>((uint8_t)3));
+
+  std::vector<uint8_t> swapped{0x20, 0x03, 0x2a, 0x01, 'x'};
+  REQUIRE(cerealise::parse_protobuf(v, swapped.data(), swapped.size()));
+  REQUIRE(v.oneof == std::variant<uint8_t, std::string>("x"));
+}
+
+TEST_CASE("protobuf parse errors") {
+  PbScalars s;
+  // wrong wire type for field 3
+  std::vector<uint8_t> wrong_type{0x18, 0x01};
+  REQUIRE(!cerealise::parse_protobuf(s, wrong_type.data(), wrong_type.size()));
+
+  // truncated length-delimited field
+  std::vector<uint8_t> truncated{0x3a, 0x05, 0x00};
+  REQUIRE(!cerealise::parse_protobuf(s, truncated.data(), truncated.size()));
+
+  // varint too big for uint32_t
+  std::vector<uint8_t> big{0x08, 0x80, 0x80, 0x80, 0x80, 0x10};
+  REQUIRE(!cerealise::parse_protobuf(s, big.data(), big.size()));
+
+  // not enough space
+  uint8_t buf[4];
+  size_t len;
+  REQUIRE(!cerealise::unparse_protobuf(PbScalars{}, buf, sizeof(buf), len));
+}
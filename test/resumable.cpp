@@ -0,0 +1,109 @@
+#include <array>
+#include <compare>
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "cerealise/array.hpp"
+#include "cerealise/cerealise.hpp"
+#include "cerealise/resumable.hpp"
+#include "cerealise/string.hpp"
+#include "cerealise/vector.hpp"
+
+struct ResumableTest {
+  std::vector<std::string> strings;
+  std::array<uint64_t, 4> big_fixed;
+  std::vector<uint32_t> ints;
+  bool flag;
+
+  auto operator<=>(const ResumableTest &) const = default;
+
+  template <typename T, typename F>
+  static constexpr bool cerealise(T &v, F &f) {
+    return f(v.strings) && f(v.big_fixed) && f(v.ints) && f(v.flag);
+  }
+};
+
+static const std::vector<ResumableTest> values = {
+    {{"a", "bc", std::string(1000, 'd')}, {1, 2, 3, 4}, {5, 6}, true},
+    {{}, {6, 7, 8, 9}, {}, false},
+    {{"e"}, {10, 11, 12, 13}, std::vector<uint32_t>(100, 14), true},
+};
+
+static std::vector<uint8_t> serialise_values() {
+  std::vector<uint8_t> buf;
+  for (auto &value : values) {
+    size_t len;
+    REQUIRE(cerealise::unparse(value, buf, len));
+  }
+  return buf;
+}
+
+/// feed buf to a parser in chunks of chunk_size bytes, checking that the
+/// values come out in order
+static void check_chunks(const std::vector<uint8_t> &buf, size_t chunk_size) {
+  cerealise::ResumableParser<ResumableTest> parser;
+  size_t n_parsed = 0;
+
+  for (size_t i = 0; i < buf.size(); i += chunk_size) {
+    parser.feed(buf.data() + i, std::min(chunk_size, buf.size() - i));
+
+    bool complete;
+    while (true) {
+      REQUIRE(parser.poll(complete));
+      if (!complete)
+        break;
+      REQUIRE(n_parsed < values.size());
+      REQUIRE(parser.value() == values[n_parsed]);
+      REQUIRE(parser.bytes_read() == cerealise::measure(values[n_parsed]));
+      n_parsed++;
+    }
+  }
+  REQUIRE(n_parsed == values.size());
+
+  // end of input between values is fine
+  parser.finish_input();
+  bool complete;
+  REQUIRE(parser.poll(complete));
+  REQUIRE(!complete);
+}
+
+TEST_CASE("resumable parse") {
+  auto buf = serialise_values();
+  for (size_t chunk_size : {1, 2, 3, 7, 64, 1000, 5000})
+    check_chunks(buf, chunk_size);
+}
+
+TEST_CASE("resumable parse errors") {
+  auto buf = serialise_values();
+  size_t first_len = cerealise::measure(values[0]);
+
+  SECTION("input ends part way through a value") {
+    cerealise::ResumableParser<ResumableTest> parser;
+    parser.feed(buf.data(), first_len + 10);
+
+    bool complete;
+    REQUIRE(parser.poll(complete));
+    REQUIRE(complete);
+    REQUIRE(parser.poll(complete));
+    REQUIRE(!complete);
+
+    parser.finish_input();
+    REQUIRE(!parser.poll(complete));
+    REQUIRE(!parser.poll(complete));
+  }
+
+  SECTION("invalid data") {
+    // a vector longer than the allocation budget allows
+    cerealise::ParseOptions options;
+    options.alloc_budget = 1000;
+    cerealise::ResumableParser<ResumableTest> parser(options);
+
+    uint8_t huge[] = {0xff, 0xff, 0xff, 0x7f};
+    parser.feed(huge, sizeof(huge));
+
+    bool complete;
+    REQUIRE(!parser.poll(complete));
+    REQUIRE(!complete);
+  }
+}
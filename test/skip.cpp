@@ -0,0 +1,82 @@
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "catch.hpp"
+#include "cerealise/array.hpp"
+#include "cerealise/cerealise.hpp"
+#include "cerealise/optional.hpp"
+#include "cerealise/string.hpp"
+#include "cerealise/variant.hpp"
+#include "cerealise/vector.hpp"
+
+struct SkipFixed {
+  bool flag;
+  uint32_t x;
+  std::array<double, 3> y;
+
+  template <typename T, typename F>
+  static constexpr bool cerealise(T &v, F &f) {
+    return f(v.flag) && f(v.x) && f(v.y);
+  }
+};
+
+template <> struct cerealise::FixedSizeTrait<SkipFixed> : std::true_type {};
+static_assert(cerealise::has_fixed_size_v<SkipFixed>);
+
+struct SkipTest {
+  uint64_t id;
+  std::string name;
+  std::vector<SkipFixed> fixed;
+  std::vector<std::string> names;
+  std::optional<SkipFixed> opt;
+  std::variant<uint8_t, std::vector<uint16_t>> var;
+
+  template <typename T, typename F> static bool cerealise(T &v, F &f) {
+    return f(v.id) && f(v.name) && f(v.fixed) && f(v.names) && f(v.opt) &&
+           f(v.var);
+  }
+};
+
+template <typename T> void check_skip(const T &v) {
+  std::vector<uint8_t> buf;
+  size_t len;
+  REQUIRE(cerealise::unparse(v, buf, len));
+
+  // followed by other data
+  buf.push_back(0xff);
+  size_t skipped;
+  REQUIRE(cerealise::skip<T>(buf.data(), buf.size(), skipped));
+  REQUIRE(skipped == len);
+
+  // every truncation point of small values, or a sample of them
+  size_t step = std::max<size_t>(1, len / 64);
+  for (size_t i = 0; i < len; i += step)
+    REQUIRE(!cerealise::skip<T>(buf.data(), i, skipped));
+  REQUIRE(!cerealise::skip<T>(buf.data(), len - 1, skipped));
+}
+
+TEST_CASE("skip") {
+  check_skip(SkipFixed{true, 1, {1.0, 2.0, 3.0}});
+  check_skip(SkipTest{});
+  check_skip(SkipTest{5,
+                      "name",
+                      {{true, 1, {}}, {false, 2, {}}},
+                      {"a", "bc", ""},
+                      SkipFixed{true, 3, {}},
+                      std::vector<uint16_t>{1, 2, 3}});
+}
+
+TEST_CASE("skip large") {
+  SkipTest v;
+  v.fixed.resize(10000);
+  check_skip(v);
+
+  // a length which does not fit is rejected without looking at each element
+  std::vector<uint8_t> buf{0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff, 0x7f};
+  size_t skipped;
+  REQUIRE(!cerealise::skip<SkipTest>(buf.data(), buf.size(), skipped));
+}
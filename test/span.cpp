@@ -0,0 +1,27 @@
+#include <algorithm>
+#include <span>
+#include <vector>
+
+#include "catch.hpp"
+#include "cerealise/cerealise.hpp"
+#include "cerealise/span.hpp"
+#include "cerealise/vector.hpp"
+
+TEST_CASE("span") {
+  std::vector<uint8_t> vec{1, 2, 3};
+  std::vector<uint8_t> buf;
+  size_t len;
+  REQUIRE(cerealise::unparse(vec, buf, len));
+
+  std::span<const uint8_t> span;
+  REQUIRE(cerealise::parse(span, buf.data(), buf.size(), len));
+  REQUIRE(len == 4);
+  REQUIRE(span.data() == buf.data() + 1);
+  REQUIRE(std::equal(span.begin(), span.end(), vec.begin(), vec.end()));
+
+  std::vector<uint8_t> buf2;
+  REQUIRE(cerealise::unparse(span, buf2, len));
+  REQUIRE(buf2 == buf);
+
+  REQUIRE(!cerealise::parse(span, buf.data(), buf.size() - 1, len));
+}
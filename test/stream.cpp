@@ -0,0 +1,86 @@
+#include <array>
+#include <compare>
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "catch.hpp"
+#include "cerealise/array.hpp"
+#include "cerealise/cerealise.hpp"
+#include "cerealise/stream.hpp"
+#include "cerealise/string.hpp"
+#include "cerealise/vector.hpp"
+
+struct StreamTest {
+  std::vector<std::string> strings;
+  std::array<uint64_t, 4> big_fixed;
+  uint32_t x;
+
+  auto operator<=>(const StreamTest &) const = default;
+
+  template <typename T, typename F>
+  static constexpr bool cerealise(T &v, F &f) {
+    return f(v.strings) && f(v.big_fixed) && f(v.x);
+  }
+};
+
+static const StreamTest values[] = {
+    {{"a", "bc", std::string(100, 'd')}, {1, 2, 3, 4}, 5},
+    {{}, {6, 7, 8, 9}, 10},
+};
+
+TEST_CASE("FILE stream") {
+  FILE *file = tmpfile();
+  REQUIRE(file);
+
+  uint8_t buf[16];
+  cerealise::FileSink sink(file, buf, sizeof(buf));
+  for (auto &value : values) {
+    size_t len;
+    REQUIRE(cerealise::unparse(value, sink, len));
+    REQUIRE(len == cerealise::measure(value));
+  }
+  REQUIRE(sink.flush());
+
+  rewind(file);
+
+  cerealise::FileSource source(file, buf, sizeof(buf));
+  for (auto &value : values) {
+    StreamTest parsed;
+    size_t len;
+    REQUIRE(cerealise::parse(parsed, source, len));
+    REQUIRE(len == cerealise::measure(value));
+    REQUIRE(parsed == value);
+  }
+
+  // end of file
+  StreamTest parsed;
+  size_t len;
+  REQUIRE(!cerealise::parse(parsed, source, len));
+
+  fclose(file);
+}
+
+TEST_CASE("fd stream") {
+  int fds[2];
+  REQUIRE(pipe(fds) == 0);
+
+  uint8_t buf[32];
+  cerealise::FdSink sink(fds[1], buf, sizeof(buf));
+  for (auto &value : values) {
+    size_t len;
+    REQUIRE(cerealise::unparse(value, sink, len));
+  }
+  REQUIRE(sink.flush());
+  close(fds[1]);
+
+  cerealise::FdSource source(fds[0], buf, sizeof(buf));
+  for (auto &value : values) {
+    StreamTest parsed;
+    size_t len;
+    REQUIRE(cerealise::parse(parsed, source, len));
+    REQUIRE(parsed == value);
+  }
+  close(fds[0]);
+}
@@ -11,3 +11,18 @@ TEST_CASE("long string") {
   std::string longstr(255, 'a');
   check_parse_unparse(longstr, longstr.size() + 2);
 }
+
+TEST_CASE("string hostile length") {
+  // 1000 bytes declared, 3 present
+  uint8_t buf[] = {0x87, 0x68, 'a', 'b', 'c'};
+  std::string s;
+  size_t len;
+  REQUIRE(!cerealise::parse(s, buf, sizeof(buf), len));
+
+  cerealise::ParseOptions options{.alloc_budget = 2};
+  uint8_t short_buf[] = {3, 'a', 'b', 'c'};
+  REQUIRE(!cerealise::parse(s, short_buf, sizeof(short_buf), len, options));
+  options.alloc_budget = 3;
+  REQUIRE(cerealise::parse(s, short_buf, sizeof(short_buf), len, options));
+  REQUIRE(s == "abc");
+}
@@ -0,0 +1,24 @@
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "catch.hpp"
+#include "cerealise/cerealise.hpp"
+#include "cerealise/string.hpp"
+#include "cerealise/string_view.hpp"
+#include "cerealise/vector.hpp"
+#include "utils.hpp"
+
+TEST_CASE("string_view") {
+  check_parse_unparse(std::string_view{"OHAI"}, 5);
+
+  std::string str{"OHAI"};
+  std::vector<uint8_t> buf;
+  size_t len;
+  REQUIRE(cerealise::unparse(str, buf, len));
+
+  std::string_view view;
+  REQUIRE(cerealise::parse(view, buf.data(), buf.size(), len));
+  REQUIRE(view == str);
+  REQUIRE((const uint8_t *)view.data() == buf.data() + 1);
+}
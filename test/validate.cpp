@@ -0,0 +1,105 @@
+#include <optional>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "catch.hpp"
+#include "cerealise/cerealise.hpp"
+#include "cerealise/delta.hpp"
+#include "cerealise/optional.hpp"
+#include "cerealise/string.hpp"
+#include "cerealise/variant.hpp"
+#include "cerealise/vector.hpp"
+
+struct ValidateInner {
+  bool flag;
+  uint16_t x;
+
+  template <typename T, typename F>
+  static constexpr bool cerealise(T &v, F &f) {
+    return f(v.flag) && f(v.x);
+  }
+};
+
+template <>
+struct cerealise::FixedSizeTrait<ValidateInner> : std::true_type {};
+
+struct ValidateTest {
+  std::string name;
+  std::vector<uint32_t> values;
+  std::vector<ValidateInner> inner;
+  std::optional<std::string> opt;
+  std::variant<uint8_t, std::string> var;
+  std::vector<int64_t> deltas;
+
+  template <typename T, typename F> static bool cerealise(T &v, F &f) {
+    return f(v.name) && f(v.values) && f(v.inner) && f(v.opt) && f(v.var) &&
+           cerealise::delta_packed(f, v.deltas);
+  }
+};
+
+static std::vector<uint8_t> unparse_test(const ValidateTest &v) {
+  std::vector<uint8_t> buf;
+  size_t len;
+  REQUIRE(cerealise::unparse(v, buf, len));
+  return buf;
+}
+
+static bool validate_test(const std::vector<uint8_t> &buf) {
+  size_t len;
+  return cerealise::validate<ValidateTest>(buf.data(), buf.size(), len);
+}
+
+TEST_CASE("validate") {
+  ValidateTest v{"abc",    {1, 2, 3}, {{true, 5}, {false, 6}},
+                 "opt",    "var",     {100, 105, 90, 1000}};
+  std::vector<uint8_t> buf = unparse_test(v);
+
+  size_t len;
+  REQUIRE(cerealise::validate<ValidateTest>(buf.data(), buf.size(), len));
+  REQUIRE(len == buf.size());
+
+  // trailing data is allowed, as with parse
+  buf.push_back(0);
+  REQUIRE(cerealise::validate<ValidateTest>(buf.data(), buf.size(), len));
+  REQUIRE(len == buf.size() - 1);
+  buf.pop_back();
+
+  // every truncation fails
+  for (size_t i = 0; i < buf.size(); i++)
+    REQUIRE(!cerealise::validate<ValidateTest>(buf.data(), i, len));
+
+  REQUIRE(validate_test(unparse_test({})));
+}
+
+TEST_CASE("validate errors") {
+  // name, values, one inner value, then nothing, variant index, deltas
+  std::vector<uint8_t> good{0, 0, 1, 1, 0, 5, 0, 0, 1, 0};
+  REQUIRE(validate_test(good));
+
+  auto bad = good;
+  bad[3] = 2; // bool in inner
+  REQUIRE(!validate_test(bad));
+
+  bad = good;
+  bad[6] = 2; // optional flag
+  REQUIRE(!validate_test(bad));
+
+  bad = good;
+  bad[7] = 2; // variant index
+  REQUIRE(!validate_test(bad));
+
+  // huge vector length
+  std::vector<uint8_t> huge{0, 0xff, 0xff, 0xff, 0xff, 0x7f, 0, 0, 0};
+  REQUIRE(!validate_test(huge));
+
+  // varint overflow in name length
+  std::vector<uint8_t> overflow(12, 0xff);
+  REQUIRE(!validate_test(overflow));
+
+  // delta width too large: count 2, first value 0, width 65
+  bad = good;
+  bad.resize(9);
+  bad.insert(bad.end(), {2, 0, 65, 0, 0, 0, 0, 0, 0, 0, 0, 0});
+  REQUIRE(!validate_test(bad));
+}
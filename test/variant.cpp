@@ -1,8 +1,12 @@
+#include <string>
 #include <variant>
+#include <vector>
 
 #include "catch.hpp"
 #include "cerealise/cerealise.hpp"
+#include "cerealise/string.hpp"
 #include "cerealise/variant.hpp"
+#include "cerealise/vector.hpp"
 #include "utils.hpp"
 
 using T = std::variant<uint8_t, uint32_t>;
@@ -11,3 +15,64 @@ TEST_CASE("variant") {
   check_parse_unparse<T>((uint8_t)5, 2);
   check_parse_unparse<T>((uint32_t)5, 5);
 }
+
+TEST_CASE("variant bad index") {
+  uint8_t buf[] = {2, 0, 0, 0, 0};
+  T v;
+  size_t len;
+  REQUIRE(!cerealise::parse(v, buf, sizeof(buf), len));
+}
+
+/// counts copies, to check that variants are parsed and unparsed in place
+struct CopyCounter {
+  static inline size_t copies = 0;
+
+  uint8_t x = 0;
+
+  CopyCounter() = default;
+  CopyCounter(uint8_t x) : x(x) {}
+  CopyCounter(const CopyCounter &other) : x(other.x) { copies++; }
+  CopyCounter &operator=(const CopyCounter &other) {
+    x = other.x;
+    copies++;
+    return *this;
+  }
+
+  template <typename TT, typename F> static bool cerealise(TT &v, F &f) {
+    return f(v.x);
+  }
+
+  bool operator==(const CopyCounter &) const = default;
+};
+
+using Many = std::variant<std::string, std::vector<uint32_t>, CopyCounter>;
+
+TEST_CASE("variant many alternatives") {
+  check_parse_unparse<Many>(std::string("abc"));
+  check_parse_unparse<Many>(std::vector<uint32_t>{1, 2, 3});
+
+  Many v1 = CopyCounter(7);
+  uint8_t buf[2];
+  size_t len;
+  CopyCounter::copies = 0;
+  REQUIRE(cerealise::unparse(v1, buf, sizeof(buf), len));
+
+  Many v2;
+  REQUIRE(cerealise::parse(v2, buf, len, len));
+  REQUIRE(v1 == v2);
+  REQUIRE(CopyCounter::copies == 0);
+}
+
+TEST_CASE("variant reuses current alternative") {
+  std::vector<uint32_t> big(1000, 5);
+  Many v1 = big;
+  std::vector<uint8_t> buf;
+  size_t len;
+  REQUIRE(cerealise::unparse(v1, buf, len));
+
+  Many v2 = std::vector<uint32_t>(2000);
+  const uint32_t *data = std::get<1>(v2).data();
+  REQUIRE(cerealise::parse(v2, buf.data(), buf.size(), len));
+  REQUIRE(v2 == v1);
+  REQUIRE(std::get<1>(v2).data() == data);
+}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <vector>
 
 #include "catch.hpp"
@@ -6,3 +7,135 @@
 #include "utils.hpp"
 
 TEST_CASE("vector") { check_parse_unparse(std::vector<uint32_t>{1, 2, 3}, 13); }
+
+TEST_CASE("unparse to vector") {
+  std::vector<uint32_t> v(1000);
+  for (size_t i = 0; i < v.size(); i++)
+    v[i] = i;
+
+  std::vector<uint8_t> expected(cerealise::measure(v));
+  size_t len;
+  REQUIRE(cerealise::unparse(v, expected.data(), expected.size(), len));
+
+  std::vector<uint8_t> buf{1, 2, 3};
+  REQUIRE(cerealise::unparse(v, buf, len));
+  REQUIRE(len == expected.size());
+  REQUIRE(buf.size() == 3 + expected.size());
+  REQUIRE(std::equal(expected.begin(), expected.end(), buf.begin() + 3));
+
+  // capacity is reused after clearing
+  buf.clear();
+  const uint8_t *data = buf.data();
+  REQUIRE(cerealise::unparse(v, buf, len));
+  REQUIRE(buf == expected);
+  REQUIRE(buf.data() == data);
+}
+
+template <typename T> struct ElementWise {
+  std::vector<T> v;
+
+  template <typename TT, typename F> static bool cerealise(TT &v, F &f) {
+    size_t size = v.v.size();
+    if (!f.varint(size))
+      return false;
+    for (auto &element : v.v)
+      if (!f(element))
+        return false;
+    return true;
+  }
+};
+
+template <typename T> void check_block(size_t n) {
+  std::vector<T> v(n);
+  for (size_t i = 0; i < n; i++)
+    v[i] = (T)(i * 0x01020304050607 + 1);
+
+  check_parse_unparse(v, 1 + n * sizeof(T));
+
+  // same format as unparsing one at a time
+  std::vector<uint8_t> block, element_wise;
+  size_t len;
+  REQUIRE(cerealise::unparse(v, block, len));
+  REQUIRE(cerealise::unparse(ElementWise<T>{v}, element_wise, len));
+  REQUIRE(block == element_wise);
+}
+
+TEST_CASE("vector blocks") {
+  for (size_t n : {0, 1, 7, 31, 100}) {
+    check_block<uint16_t>(n);
+    check_block<int32_t>(n);
+    check_block<uint64_t>(n);
+    check_block<float>(n);
+    check_block<double>(n);
+  }
+}
+
+TEST_CASE("vector hostile lengths") {
+  // 2^35 elements declared in a 6-byte buffer
+  uint8_t huge[] = {0x80 | 0x40, 0x80, 0x80, 0x80, 0x80, 0x00};
+  size_t len;
+  std::vector<uint64_t> v;
+  REQUIRE(!cerealise::parse(v, huge, sizeof(huge), len));
+  REQUIRE(v.capacity() == 0);
+
+  // elements with a variable size take at least one byte each
+  std::vector<std::vector<uint8_t>> nested;
+  uint8_t three[] = {3, 0, 0};
+  REQUIRE(!cerealise::parse(nested, three, sizeof(three), len));
+  REQUIRE(nested.capacity() == 0);
+  uint8_t three_ok[] = {3, 0, 0, 0};
+  REQUIRE(cerealise::parse(nested, three_ok, sizeof(three_ok), len));
+
+  // validate and skip make the same check rather than looping over each one
+  // 2^64 - 1
+  uint8_t huge_nested[] = {0x81, 0xff, 0xff, 0xff, 0xff, 0xff,
+                           0xff, 0xff, 0xff, 0x7f, 0,    0};
+  using Nested = std::vector<std::vector<uint8_t>>;
+  REQUIRE(!cerealise::validate<Nested>(huge_nested, sizeof(huge_nested), len));
+  REQUIRE(!cerealise::skip<Nested>(huge_nested, sizeof(huge_nested), len));
+  REQUIRE(!cerealise::validate<Nested>(three, sizeof(three), len));
+  REQUIRE(cerealise::validate<Nested>(three_ok, sizeof(three_ok), len));
+  REQUIRE(len == sizeof(three_ok));
+}
+
+/// a type which is encoded in zero bytes, without being declared fixed size
+struct Empty {
+  template <typename T, typename F> static bool cerealise(T &, F &) {
+    return true;
+  }
+  bool operator==(const Empty &) const = default;
+};
+
+TEST_CASE("vector zero size elements") {
+  uint8_t buf[] = {100};
+  size_t len;
+  std::vector<Empty> v;
+  REQUIRE(cerealise::parse(v, buf, sizeof(buf), len));
+  REQUIRE(v.size() == 100);
+  REQUIRE(len == 1);
+
+  // every element is read in the same way, so they are not all checked
+  uint8_t huge[] = {0x81, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x7f};
+  REQUIRE(cerealise::validate<std::vector<Empty>>(huge, sizeof(huge), len));
+  REQUIRE(len == sizeof(huge));
+  REQUIRE(cerealise::skip<std::vector<Empty>>(huge, sizeof(huge), len));
+  REQUIRE(len == sizeof(huge));
+}
+
+TEST_CASE("vector allocation budget") {
+  std::vector<std::vector<uint32_t>> v(3, std::vector<uint32_t>(10));
+  std::vector<uint8_t> buf;
+  size_t len;
+  REQUIRE(cerealise::unparse(v, buf, len));
+
+  // the outer vector, then each inner vector
+  size_t needed = 3 * sizeof(std::vector<uint32_t>) + 30 * sizeof(uint32_t);
+
+  std::vector<std::vector<uint32_t>> parsed;
+  cerealise::ParseOptions options{.alloc_budget = needed};
+  REQUIRE(cerealise::parse(parsed, buf.data(), buf.size(), len, options));
+  REQUIRE(parsed == v);
+
+  options.alloc_budget = needed - 1;
+  REQUIRE(!cerealise::parse(parsed, buf.data(), buf.size(), len, options));
+}